@@ -0,0 +1,240 @@
+#include "Bot.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static const float Never = std::numeric_limits<float>::infinity();
+static const float Horizon = 1.f; // (seconds; a plan is redone many times over before the siphon gets that far)
+
+// times at which two 8x8 boxes, 'start' apart along one axis and drifting apart at 'delta', overlap on that axis:
+static glm::vec2 slab(float start, float delta)
+{
+    if (delta == 0.f) {
+        return std::abs(start) < 8.f ? glm::vec2(0.f, Never) : glm::vec2(Never, 0.f);
+    }
+    const float inverse = 1.f / delta; // (one division instead of two; plan() calls this a lot)
+    const float t0 = (-8.f - start) * inverse;
+    const float t1 = (8.f - start) * inverse;
+    return glm::vec2(std::min(t0, t1), std::max(t0, t1));
+}
+
+// first time in [0, t_max] at which 8x8 boxes at 'a' and 'b', moving with velocities 'va' and 'vb', overlap:
+//  (the same slab test as Object::timeOfImpact, over a longer time)
+static float intercept(glm::vec2 a, glm::vec2 va, glm::vec2 b, glm::vec2 vb, float t_max)
+{
+    const glm::vec2 x = slab(b.x - a.x, vb.x - va.x);
+    const glm::vec2 y = slab(b.y - a.y, vb.y - va.y);
+    const float t_enter = std::max({ 0.f, x[0], y[0] });
+    const float t_exit = std::min({ t_max, x[1], y[1] });
+    return t_enter < t_exit ? t_enter : Never;
+}
+
+static bool on_screen(glm::vec2 pos)
+{
+    return pos.x >= 0 && pos.y >= 0 && pos.x <= PPU466::ScreenWidth && pos.y <= PPU466::ScreenHeight;
+}
+
+// time until something at 'pos' moving at 'vel' leaves the screen (and respawns elsewhere):
+static float exit_time(glm::vec2 pos, glm::vec2 vel)
+{
+    float t = Never;
+    const glm::vec2 size = glm::vec2(PPU466::ScreenWidth, PPU466::ScreenHeight);
+    for (int axis = 0; axis < 2; axis++) {
+        if (vel[axis] > 0.f) {
+            t = std::min(t, (size[axis] - pos[axis]) / vel[axis]);
+        } else if (vel[axis] < 0.f) {
+            t = std::min(t, -pos[axis] / vel[axis]);
+        }
+    }
+    return t;
+}
+
+// where (and when) the siphon could catch up with 'p', if it heads straight there:
+//  ('inverse_speed' is 1 / siphon.speed, so the iterations don't each wait on a division)
+static glm::vec2 meeting_point(Siphon const& siphon, float inverse_speed, MovingObject const& p, float* time)
+{
+    glm::vec2 meet = p.pos;
+    float t = 0.f;
+    for (uint32_t iteration = 0; iteration < 3; ++iteration) {
+        // (the siphon moves at full speed along each axis independently)
+        glm::vec2 to = meet - siphon.pos;
+        t = std::max(std::abs(to.x), std::abs(to.y)) * inverse_speed;
+        meet = p.pos + t * p.vel;
+    }
+    *time = t;
+    return meet;
+}
+
+// the direction to redirect a projectile met at 'meet' ('delay' seconds from now) in, so that its bolt soonest hits
+//  the most valuable target -- weighing points by the time until the hit -- or -1 if no hit is worth more than '*best'
+//  (which is raised to the value of the chosen hit):
+static int best_aim(Bot::Target const* targets, uint32_t count, glm::vec2 meet, float speed, float delay, float* best)
+{
+    // (a bolt only ever moves along one axis, so when a target lines up with it on the other axis is the same
+    //  for both directions along that axis; work that out once per target, not once per direction)
+    int aim = -1;
+    for (uint32_t i = 0; i < count; ++i) {
+        Bot::Target const& target = targets[i];
+        const float target_exit = target.exit - delay;
+        if (target_exit <= 0.f) {
+            continue; // (gone by then)
+        }
+        if (*best > 0.f && target.points <= *best * (delay + 0.25f)) {
+            continue; // (not worth enough to beat '*best' even if hit straight away)
+        }
+        const glm::vec2 start = target.pos + delay * target.vel - meet;
+        const glm::vec2 lined_up[2] = { slab(start.x, target.vel.x), slab(start.y, target.vel.y) };
+        for (int direction = 0; direction < 4; direction++) {
+            const glm::vec2 vel = speed * MovingObject::directionMapping(direction);
+            const int along = vel.x != 0.f ? 0 : 1;
+            // (only hits sooner than this can beat '*best', so there's no need to look any further ahead)
+            const float limit = *best > 0.f ? target.points / *best - delay - 0.25f : Never;
+            const glm::vec2 across = lined_up[1 - along];
+            const float t_end = std::min({ exit_time(meet, vel), target_exit, limit, across[1] });
+            if (across[0] >= t_end) {
+                continue; // (never lines up in time)
+            }
+            const glm::vec2 closing = slab(start[along], target.vel[along] - vel[along]);
+            const float t = std::max({ 0.f, closing[0], across[0] });
+            if (t < std::min(t_end, closing[1]) && target.points > *best * (delay + t + 0.25f)) {
+                *best = target.points / (delay + t + 0.25f);
+                aim = direction;
+            }
+        }
+    }
+    return aim;
+}
+
+// whether a bolt at 'pos' moving at 'vel' hits any target before it leaves the screen at 't_max' (stops at the first):
+static bool hits_any(Bot::Target const* targets, uint32_t count, glm::vec2 pos, glm::vec2 vel, float t_max)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        if (intercept(pos, vel, targets[i].pos, targets[i].vel, std::min(t_max, targets[i].exit)) != Never) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Bot::Bot(uint8_t player_, uint32_t replan_ticks_)
+    : player(player_)
+    , replan_ticks(std::max(1U, replan_ticks_))
+{
+}
+
+void Bot::plan(Game const& game)
+{
+    // gather the targets once:
+    target_count = 0;
+    float most_points = 0.f;
+    auto gather = [&](EntityPool<MovingObject, Game::MaxTargets> const& pool, float points) {
+        for (MovingObject const& t : pool) {
+            targets[target_count++] = Target { t.pos, t.vel, exit_time(t.pos, t.vel), points };
+            most_points = std::max(most_points, points);
+        }
+    };
+    gather(game.targets, float(game.config.target_points));
+    gather(game.superTargets, float(game.config.super_target_points));
+
+    // where the siphon could meet each projectile, soonest first:
+    Siphon const& siphon = game.siphons[player];
+    struct Candidate {
+        uint32_t index;
+        glm::vec2 meet;
+        float t;
+        float exit; // seconds until the projectile leaves the screen
+    };
+    std::array<Candidate, Game::MaxProjectiles> candidates;
+    uint32_t candidate_count = 0;
+    const float inverse_speed = 1.f / siphon.speed;
+    for (uint32_t i = 0; i < game.projectiles.count; ++i) {
+        MovingObject const& p = game.projectiles.items[i];
+        if (p.collision) {
+            continue; // (just redirected; leave it alone)
+        }
+        float t;
+        glm::vec2 meet = meeting_point(siphon, inverse_speed, p, &t);
+        if (on_screen(meet)) {
+            candidates[candidate_count++] = Candidate { i, meet, t, exit_time(p.pos, p.vel) };
+        }
+    }
+
+    // (insertion sort: there are only a few, and std::stable_sort would allocate)
+    for (uint32_t c = 1; c < candidate_count; ++c) {
+        Candidate candidate = candidates[c];
+        uint32_t to = c;
+        for (; to > 0 && candidates[to - 1].t > candidate.t; --to) {
+            candidates[to] = candidates[to - 1];
+        }
+        candidates[to] = candidate;
+    }
+
+    float best = 0.f;
+    chase = Handle();
+    for (uint32_t c = 0; c < candidate_count; ++c) {
+        Candidate const& candidate = candidates[c];
+        // (even the best target, hit the moment the siphon gets there, can't beat what we have; nor can anything later)
+        if (best > 0.f && most_points <= best * (candidate.t + 0.25f)) {
+            break;
+        }
+        // (and once something can be hit, meetings further off than the horizon are left for a later plan)
+        if (best > 0.f && candidate.t > Horizon) {
+            break;
+        }
+        MovingObject const& p = game.projectiles.items[candidate.index];
+        if (hits_any(targets.data(), target_count, p.pos, p.vel, candidate.exit)) {
+            continue; // (already on its way to a target; leave it alone)
+        }
+        auto choose = [&]() {
+            chase = game.projectiles.handle_at(candidate.index);
+            goal = candidate.meet;
+            goal_time_left = game.time_left - candidate.t;
+        };
+        // (if nothing can be hit, at least get close to something -- the first candidate is the closest)
+        if (chase == Handle()) {
+            choose();
+        }
+        int direction = best_aim(targets.data(), target_count, candidate.meet, p.speed, candidate.t, &best);
+        if (direction >= 0) {
+            aim = direction;
+            choose();
+        }
+        sweeps++;
+    }
+    plans++;
+}
+
+void Bot::reset()
+{
+    countdown = 0;
+    chase = Handle();
+    aim = 0;
+}
+
+uint8_t Bot::next(Game const& game)
+{
+    // (plan now and then, or when what we were chasing has gone)
+    if (countdown == 0 || (chase != Handle() && !game.projectiles.alive(chase))) {
+        plan(game);
+        countdown = replan_ticks;
+    }
+    countdown--;
+
+    // bits as in Game::set_buttons: left, right, down, up, aim_left, aim_right, aim_down, aim_up
+    static const uint8_t aim_bits[4] = { 1 << 5, 1 << 6, 1 << 4, 1 << 7 }; // (by direction)
+    uint8_t buttons = aim_bits[aim];
+
+    // (between plans, just steer towards the meeting point the plan worked out)
+    MovingObject const* p = game.projectiles.get(chase);
+    if (p) {
+        glm::vec2 to = goal - game.siphons[player].pos;
+        const float deadzone = 2.f;
+        buttons |= (to.x < -deadzone ? 1 << 0 : 0) | (to.x > deadzone ? 1 << 1 : 0);
+        buttons |= (to.y < -deadzone ? 1 << 2 : 0) | (to.y > deadzone ? 1 << 3 : 0);
+        if (p->collision || game.time_left < goal_time_left - 0.1f) {
+            countdown = 0; // (just redirected it, or it went past; find the next one)
+        }
+    }
+    return buttons;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+/*
+ * Bot -- a scripted player that produces the same Button bitmask as the keyboard.
+ *
+ * Every few ticks it plans: for each projectile it estimates where the siphon could meet it,
+ * and for each of the four aim directions whether a bolt redirected from there would run into
+ * a target (treating everything as moving in straight lines), preferring quick, valuable hits.
+ * Projectiles are tried soonest first, and the search stops once no later meeting (or later hit)
+ * could be worth more than the best found so far, or once there is something to hit and the
+ * siphon couldn't get to the rest within a second.
+ * Between plans it just steers towards the chosen meeting point, so most ticks cost very little.
+ *
+ * Usage:
+ *   Bot bot;
+ *   game.set_buttons(bot.next(game));
+ *   game.update(dt);
+ *
+ * RandomInput is the other stand-in for a player: it holds a random Button bitmask for a random number of ticks.
+ */
+
+#include "Game.hpp"
+
+#include <array>
+#include <cstdint>
+
+struct Bot {
+    Bot(uint8_t player = 0, uint32_t replan_ticks = 10);
+
+    // buttons to hold for the next tick:
+    uint8_t next(Game const& game);
+
+    // forget the current plan (e.g. once the game has been rewound), so the next call plans afresh:
+    void reset();
+
+    const uint8_t player;
+    const uint32_t replan_ticks; // ticks between plans (roughly a human reaction time)
+    uint64_t plans = 0; // plans made so far (next() calls that planned are the expensive ones)
+    uint64_t sweeps = 0; // projectiles those plans tried all four aim directions for
+
+    struct Target {
+        glm::vec2 pos, vel;
+        float exit; // seconds until it leaves the screen
+        float points;
+    };
+
+private:
+    void plan(Game const& game);
+
+    uint32_t countdown = 0; // ticks until the next plan
+    Handle chase; // projectile being chased (may have despawned)
+    int aim = 0; // direction to redirect it in
+    glm::vec2 goal = glm::vec2(0.f); // where the siphon should meet it...
+    float goal_time_left = 0.f; // ...and when (as Game::time_left)
+
+    std::array<Target, 2 * Game::MaxTargets> targets; // (scratch space for plan)
+    uint32_t target_count = 0;
+};
+
+struct RandomInput {
+    RandomInput(uint32_t seed, uint64_t stream = 1) // (a different stream than the game itself uses)
+        : rng(seed, stream)
+    {
+    }
+    Random rng;
+    uint8_t buttons = 0;
+    uint32_t hold = 0; // ticks remaining before picking new buttons
+
+    uint8_t next()
+    {
+        if (hold == 0) {
+            buttons = uint8_t(rng());
+            hold = 5 + rng() % 25;
+        }
+        hold--;
+        return buttons;
+    }
+};
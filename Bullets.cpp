@@ -0,0 +1,89 @@
+#include "Bullets.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+Pattern Pattern::load(std::string const& filename)
+{
+    std::ifstream file(filename);
+    if (!file) {
+        throw std::runtime_error("Failed to open pattern file '" + filename + "'.");
+    }
+    return parse(file, filename);
+}
+
+Pattern Pattern::parse(std::istream& from, std::string const& name)
+{
+    Pattern pattern;
+    float wave = 0.f; // start time of the current wave
+    std::string line;
+    uint32_t line_number = 0;
+    while (std::getline(from, line)) {
+        line_number++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream tokens(line);
+        std::string kind;
+        if (!(tokens >> kind)) {
+            continue; // blank line
+        }
+        auto fail = [&](std::string const& why) {
+            throw std::runtime_error("Pattern '" + name + "' line " + std::to_string(line_number) + ": " + why);
+        };
+
+        if (kind == "wave") {
+            if (!(tokens >> wave)) {
+                fail("expecting 'wave <time>'");
+            }
+            continue;
+        }
+
+        Emitter e;
+        if (kind == "radial") {
+            e.kind = Emitter::Radial;
+        } else if (kind == "spiral") {
+            e.kind = Emitter::Spiral;
+        } else if (kind == "aimed") {
+            e.kind = Emitter::Aimed;
+        } else {
+            fail("unknown emitter kind '" + kind + "'");
+        }
+        if (!(tokens >> e.start >> e.pos.x >> e.pos.y >> e.count >> e.speed >> e.period >> e.repeats >> e.param)) {
+            fail("expecting '<kind> <start> <x> <y> <count> <speed> <period> <repeats> <param>'");
+        }
+        // (written as !(period > 0) so a NaN period is rejected too)
+        if (e.count == 0 || !(e.period > 0.f) || e.repeats == 0) {
+            fail("emitters need a count > 0, a period > 0 and repeats > 0");
+        }
+        e.start += wave;
+        pattern.emitters.emplace_back(e);
+    }
+
+    std::stable_sort(pattern.emitters.begin(), pattern.emitters.end(), [](Emitter const& a, Emitter const& b) {
+        return a.start < b.start;
+    });
+    return pattern;
+}
+
+std::string Pattern::to_text() const
+{
+    std::ostringstream out;
+    out.precision(std::numeric_limits<float>::max_digits10);
+    for (Emitter const& e : emitters) {
+        out << (e.kind == Emitter::Radial ? "radial" : e.kind == Emitter::Spiral ? "spiral" : "aimed")
+            << ' ' << e.start << ' ' << e.pos.x << ' ' << e.pos.y << ' ' << e.count << ' ' << e.speed
+            << ' ' << e.period << ' ' << e.repeats << ' ' << e.param << '\n';
+    }
+    return out.str();
+}
+
+float Pattern::duration() const
+{
+    float end = 0.f;
+    for (Emitter const& e : emitters) {
+        end = std::max(end, e.start + e.period * float(e.repeats - 1));
+    }
+    return end;
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+/*
+ * Bullets -- lots of projectiles, spawned by data-driven emitter patterns.
+ *
+ * BulletPool stores bullets as parallel arrays (structure-of-arrays) with a fixed capacity:
+ *  - spawn(n) hands out n contiguous slots at once (batch allocation),
+ *  - update(dt) moves every live bullet in one tight loop and culls those that left the screen,
+ *  - live bullets are always packed into [0, count), so dead bullets cost nothing.
+ *
+ * A Pattern is a list of Emitters read from a text file (see Pattern::load for the format);
+ * PatternPlayer fires them into a pool as time passes.
+ */
+
+#include "PPU466.hpp" // just for the screen dimensions
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cmath>
+#include <iosfwd>
+#include <limits>
+#include <string>
+#include <vector>
+
+template <uint32_t Capacity>
+struct BulletPool {
+    static constexpr uint32_t capacity = Capacity;
+    uint32_t count = 0; // bullets [0, count) are live
+
+    std::array<float, Capacity> x, y; // position
+    std::array<float, Capacity> vx, vy; // velocity
+    std::array<uint8_t, Capacity> touching; // bits set while the bullet touches a siphon (see Game::BulletsUpdate)
+    std::array<uint8_t, Capacity> owner; // player who last redirected the bullet (0xff: nobody)
+
+    // batch allocation: reserves up to 'n' slots starting at the returned index
+    //  (fewer than 'n' if the pool is full; check 'count')
+    uint32_t spawn(uint32_t n)
+    {
+        uint32_t first = count;
+        n = std::min(n, Capacity - count);
+        for (uint32_t i = first; i < first + n; ++i) {
+            touching[i] = 0;
+            owner[i] = 0xff;
+        }
+        count += n;
+        return first;
+    }
+
+    // remove bullet 'i' by moving the last live bullet into its slot:
+    void despawn(uint32_t i)
+    {
+        count--;
+        x[i] = x[count];
+        y[i] = y[count];
+        vx[i] = vx[count];
+        vy[i] = vy[count];
+        touching[i] = touching[count];
+        owner[i] = owner[count];
+    }
+
+    void clear() { count = 0; }
+
+    // batch update: move everything, then cull bullets that left the screen
+    void update(float dt)
+    {
+        for (uint32_t i = 0; i < count; ++i) {
+            x[i] += dt * vx[i];
+            y[i] += dt * vy[i];
+        }
+        // (walk backwards so despawn only ever moves already-checked bullets)
+        for (uint32_t i = count; i-- > 0;) {
+            if (x[i] < 0 || y[i] < 0 || x[i] > PPU466::ScreenWidth || y[i] > PPU466::ScreenHeight) {
+                despawn(i);
+            }
+        }
+    }
+
+    // swept collision against an 8x8 box that moved from 'box_prev' to 'box_pos' during the last tick
+    //  (same test as Object::timeOfImpact; bullets are 8x8 and moved in a straight line for 'dt').
+    // calls on_hit(i, toi) for each bullet that overlapped the box, where 'toi' is in [0,1].
+    // on_hit may despawn bullet 'i' (bullets are visited from the back).
+    template <typename F>
+    void collide(glm::vec2 box_prev, glm::vec2 box_pos, float dt, F const& on_hit)
+    {
+        const glm::vec2 box_delta = box_pos - box_prev;
+        for (uint32_t i = count; i-- > 0;) {
+            // motion of the bullet relative to the box:
+            float start[2] = { x[i] - dt * vx[i] - box_prev.x, y[i] - dt * vy[i] - box_prev.y };
+            float delta[2] = { dt * vx[i] - box_delta.x, dt * vy[i] - box_delta.y };
+            float t_enter = 0.f, t_exit = 1.f;
+            for (int axis = 0; axis < 2; axis++) {
+                if (delta[axis] == 0.f) {
+                    if (std::abs(start[axis]) >= 8.f) {
+                        t_enter = std::numeric_limits<float>::infinity();
+                    }
+                    continue;
+                }
+                float t0 = (-8.f - start[axis]) / delta[axis];
+                float t1 = (8.f - start[axis]) / delta[axis];
+                t_enter = std::max(t_enter, std::min(t0, t1));
+                t_exit = std::min(t_exit, std::max(t0, t1));
+            }
+            if (t_enter < t_exit) {
+                on_hit(i, t_enter);
+            }
+        }
+    }
+};
+
+// Emitter -- one source of bullets in a Pattern.
+//  it fires 'repeats' shots, one every 'period' seconds starting at 'start';
+//  every shot is 'count' bullets at 'speed' pixels per second.
+struct Emitter {
+    enum Kind : uint8_t {
+        Radial, // evenly spaced in all directions, rotated by 'param' degrees
+        Spiral, // like Radial, but each shot is rotated a further 'param' degrees
+        Aimed, // a volley towards the target, spread over 'param' degrees
+    } kind = Radial;
+    float start = 0.f;
+    glm::vec2 pos = glm::vec2(0.f, 0.f);
+    uint32_t count = 1;
+    float speed = 50.f;
+    float period = 1.f;
+    uint32_t repeats = 1;
+    float param = 0.f;
+
+    // number of shots fired by time 't':
+    uint32_t shots_by(float t) const
+    {
+        if (t < start) {
+            return 0;
+        }
+        return std::min(repeats, uint32_t((t - start) / std::max(period, 1e-3f)) + 1);
+    }
+};
+
+struct Pattern {
+    std::vector<Emitter> emitters; // sorted by start time
+
+    // Text format, one emitter per line, '#' starts a comment:
+    //   <kind> <start> <x> <y> <count> <speed> <period> <repeats> <param>
+    //   kind is one of 'radial', 'spiral', 'aimed'
+    // a line 'wave <time>' offsets the start time of every following emitter by <time> seconds.
+    // NOTE: both will throw on error
+    static Pattern load(std::string const& filename);
+    static Pattern parse(std::istream& from, std::string const& name);
+
+    // every emitter, in the text format above (no waves), with floats written exactly (so parse() gives back an equal pattern):
+    std::string to_text() const;
+    bool operator==(Pattern const& other) const { return to_text() == other.to_text(); }
+    bool operator!=(Pattern const& other) const { return !(*this == other); }
+
+    // time at which the last shot is fired:
+    float duration() const;
+};
+
+// PatternPlayer -- plays a Pattern into a BulletPool.
+//  the only state is the current time, since the shots due by any time are known from the Pattern.
+struct PatternPlayer {
+    float time = 0.f;
+
+    // advance by 'dt' seconds and fire every shot that came due; Aimed emitters aim at 'target':
+    template <uint32_t Capacity>
+    void update(float dt, Pattern const& pattern, glm::vec2 target, BulletPool<Capacity>* pool_)
+    {
+        BulletPool<Capacity>& pool = *pool_;
+        const float before = time;
+        time += dt;
+        for (Emitter const& e : pattern.emitters) {
+            if (e.start > time) {
+                break; // (sorted by start time, so nothing later is due either)
+            }
+            for (uint32_t shot = e.shots_by(before); shot < e.shots_by(time); ++shot) {
+                uint32_t first = pool.spawn(e.count);
+                uint32_t spawned = pool.count - first;
+
+                const float to_radians = float(M_PI) / 180.f;
+                float angle = 0.f, step = 0.f;
+                if (e.kind == Emitter::Radial || e.kind == Emitter::Spiral) {
+                    angle = e.param * to_radians * (e.kind == Emitter::Spiral ? float(shot) : 1.f);
+                    step = 2.f * float(M_PI) / float(e.count);
+                } else {
+                    glm::vec2 to = target - e.pos;
+                    float spread = e.param * to_radians;
+                    angle = std::atan2(to.y, to.x) - 0.5f * spread;
+                    step = (e.count > 1 ? spread / float(e.count - 1) : 0.f);
+                    if (e.count == 1) {
+                        angle += 0.5f * spread;
+                    }
+                }
+                for (uint32_t i = 0; i < spawned; ++i) {
+                    float a = angle + step * float(i);
+                    pool.x[first + i] = e.pos.x;
+                    pool.y[first + i] = e.pos.y;
+                    pool.vx[first + i] = e.speed * std::cos(a);
+                    pool.vy[first + i] = e.speed * std::sin(a);
+                }
+            }
+        }
+    }
+};
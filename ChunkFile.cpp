@@ -0,0 +1,124 @@
+#include "ChunkFile.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+ChunkFile::ChunkFile(std::string const& filename_)
+    : filename(filename_)
+{
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open chunk file '" + filename + "'.");
+    }
+    file_handle = file;
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file, &file_size);
+    size = size_t(file_size.QuadPart);
+    if (size) {
+        mapping_handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        data = mapping_handle ? static_cast<uint8_t const*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+        if (!data) {
+            if (mapping_handle) {
+                CloseHandle(mapping_handle);
+            }
+            CloseHandle(file);
+            throw std::runtime_error("Failed to map chunk file '" + filename + "'.");
+        }
+    }
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open chunk file '" + filename + "'.");
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to stat chunk file '" + filename + "'.");
+    }
+    size = size_t(info.st_size);
+    if (size) {
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Failed to map chunk file '" + filename + "'.");
+        }
+        data = static_cast<uint8_t const*>(mapped);
+    }
+    close(fd); // (the mapping keeps the file alive)
+#endif
+
+    // index the chunks (reading only their headers):
+    //  (same header as read_chunk: four byte magic, four byte native-endian size)
+    size_t at = 0;
+    while (at < size) {
+        if (size - at < 8) {
+            unmap();
+            throw std::runtime_error("Chunk file '" + filename + "' ends in the middle of a chunk header.");
+        }
+        Chunk chunk;
+        std::memcpy(chunk.magic.data(), data + at, 4);
+        std::memcpy(&chunk.size, data + at + 4, 4);
+        chunk.offset = at + 8;
+        if (chunk.size > size - chunk.offset) {
+            unmap();
+            throw std::runtime_error("Chunk file '" + filename + "' ends in the middle of a chunk.");
+        }
+        index[std::string(chunk.magic.data(), 4)].emplace_back(uint32_t(chunks.size()));
+        chunks.emplace_back(chunk);
+        at = chunk.offset + chunk.size;
+    }
+}
+
+ChunkFile::~ChunkFile()
+{
+    unmap();
+}
+
+void ChunkFile::unmap()
+{
+#if defined(_WIN32)
+    if (data) {
+        UnmapViewOfFile(data);
+    }
+    if (mapping_handle) {
+        CloseHandle(mapping_handle);
+    }
+    if (file_handle) {
+        CloseHandle(file_handle);
+    }
+    mapping_handle = file_handle = nullptr;
+#else
+    if (data) {
+        munmap(const_cast<uint8_t*>(data), size);
+    }
+#endif
+    data = nullptr;
+}
+
+ChunkFile::Chunk const* ChunkFile::find(std::string const& magic, uint32_t nth) const
+{
+    auto found = index.find(magic);
+    if (found == index.end() || nth >= found->second.size()) {
+        return nullptr;
+    }
+    return &chunks[found->second[nth]];
+}
+
+ChunkFile::Chunk const& ChunkFile::get(std::string const& magic, uint32_t nth, size_t element_size) const
+{
+    Chunk const* chunk = find(magic, nth);
+    if (!chunk) {
+        throw std::runtime_error("Chunk file '" + filename + "' has no chunk '" + magic + "'.");
+    }
+    if (chunk->size % element_size != 0) {
+        throw std::runtime_error("Size of chunk '" + magic + "' in '" + filename + "' not divisible by element size.");
+    }
+    return *chunk;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+/*
+ * ChunkFile -- read-only, memory-mapped access to a file of chunks (as written by write_chunk).
+ *
+ * Opening a file maps it and walks just the chunk headers to build an index, so it takes about the
+ * same time however big the chunks are; their contents are paged in by the OS when first touched.
+ * view<T>() hands back a typed pointer + count straight into the mapping (no copies), after checking
+ * that the chunk holds a whole number of T's and is suitably aligned for T.
+ *
+ * Usage:
+ *   ChunkFile file("tiles.chunks");
+ *   ChunkView<PPU466::Tile> tiles = file.view<PPU466::Tile>("tile");
+ *   PPU466::Tile const& t = tiles[1000];
+ *
+ * Views (and Chunk pointers) are only good for as long as the ChunkFile is.
+ */
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+template <typename T>
+struct ChunkView {
+    T const* data = nullptr;
+    size_t count = 0;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T const& operator[](size_t i) const { return data[i]; }
+    T const* begin() const { return data; }
+    T const* end() const { return data + count; }
+};
+
+struct ChunkFile {
+    // NOTE: throws on error (including a chunk running past the end of the file)
+    ChunkFile(std::string const& filename);
+    ~ChunkFile();
+    ChunkFile(ChunkFile const&) = delete;
+    ChunkFile& operator=(ChunkFile const&) = delete;
+
+    struct Chunk {
+        std::array<char, 4> magic;
+        size_t offset; // of the contents (just past the header)
+        uint32_t size; // in bytes
+    };
+    std::vector<Chunk> chunks; // in file order
+
+    // the 'nth' chunk with a given magic number (nullptr if there isn't one):
+    Chunk const* find(std::string const& magic, uint32_t nth = 0) const;
+
+    // contents of a chunk, in place
+    //  NOTE: throws if it's missing, not a whole number of T's, or misaligned for T
+    template <typename T>
+    ChunkView<T> view(std::string const& magic, uint32_t nth = 0) const
+    {
+        Chunk const& chunk = get(magic, nth, sizeof(T));
+        uint8_t const* at = data + chunk.offset;
+        if (reinterpret_cast<uintptr_t>(at) % alignof(T) != 0) {
+            throw std::runtime_error("Chunk '" + magic + "' in '" + filename + "' is not aligned for its contents.");
+        }
+        return ChunkView<T> { reinterpret_cast<T const*>(at), chunk.size / sizeof(T) };
+    }
+
+    // copy of the contents of a chunk (for chunks that can't be viewed in place because of alignment)
+    //  NOTE: throws if it's missing or not a whole number of T's
+    template <typename T>
+    void read(std::string const& magic, std::vector<T>* to, uint32_t nth = 0) const
+    {
+        Chunk const& chunk = get(magic, nth, sizeof(T));
+        to->resize(chunk.size / sizeof(T));
+        if (chunk.size) {
+            std::memcpy(to->data(), data + chunk.offset, chunk.size);
+        }
+    }
+
+    const std::string filename;
+    uint8_t const* data = nullptr; // the whole file
+    size_t size = 0;
+
+private:
+    void unmap();
+    Chunk const& get(std::string const& magic, uint32_t nth, size_t element_size) const;
+
+    std::unordered_map<std::string, std::vector<uint32_t>> index; // magic -> indices into chunks
+
+#if defined(_WIN32)
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+/*
+ * EntityPool -- fixed-capacity storage for game entities with O(1) spawn and despawn.
+ *
+ * Live entities are kept packed at the front of 'items' (indices [0, count)), so updating
+ * them is a plain loop over an array and dead entities cost nothing per frame.
+ *
+ * Because entities move around inside 'items' when others despawn, anything that needs to
+ * refer to one particular entity over time should keep a Handle instead of an index:
+ *  a Handle names a slot plus the generation of that slot; the generation is bumped every
+ *  time the slot's entity despawns, so stale handles are detected instead of silently
+ *  referring to whichever entity reused the slot.
+ *
+ * Everything lives in fixed-size arrays, so a pool of trivially copyable T is itself
+ * trivially copyable.
+ */
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+
+struct Handle {
+    uint16_t slot = 0xffff;
+    uint16_t generation = 0;
+
+    bool operator==(Handle const& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(Handle const& other) const { return !(*this == other); }
+};
+
+template <typename T, uint32_t Capacity>
+struct EntityPool {
+    static_assert(Capacity < 0xffff, "slots must fit in a Handle");
+    static constexpr uint32_t capacity = Capacity;
+
+    EntityPool()
+    {
+        for (uint32_t s = 0; s < Capacity; ++s) {
+            free_slots[s] = uint16_t(Capacity - 1 - s); // (so slot 0 is handed out first)
+            generation[s] = 0;
+            item_slot[s] = slot_item[s] = 0xffff;
+        }
+    }
+
+    uint32_t count = 0; // live entities are items[0, count)
+    std::array<T, Capacity> items;
+
+    bool full() const { return count == Capacity; }
+
+    // add an entity (the pool must not be full):
+    Handle spawn(T const& item)
+    {
+        assert(!full());
+        uint16_t slot = free_slots[--free_count];
+        items[count] = item;
+        item_slot[count] = slot;
+        slot_item[slot] = uint16_t(count);
+        count++;
+        return Handle { slot, generation[slot] };
+    }
+
+    // remove the entity at items[i] by moving the last live entity into its place:
+    //  (when removing while looping over items, loop backwards)
+    void despawn_at(uint32_t i)
+    {
+        assert(i < count);
+        uint16_t slot = item_slot[i];
+        generation[slot]++;
+        free_slots[free_count++] = slot;
+        count--;
+        if (i != count) {
+            items[i] = items[count];
+            item_slot[i] = item_slot[count];
+            slot_item[item_slot[i]] = uint16_t(i);
+        }
+    }
+
+    // remove an entity by handle; returns false if it was already gone:
+    bool despawn(Handle h)
+    {
+        if (!alive(h)) {
+            return false;
+        }
+        despawn_at(slot_item[h.slot]);
+        return true;
+    }
+
+    bool alive(Handle h) const { return h.slot < Capacity && generation[h.slot] == h.generation && slot_item[h.slot] < count && item_slot[slot_item[h.slot]] == h.slot; }
+
+    // look up an entity by handle (nullptr if it has despawned):
+    T* get(Handle h) { return alive(h) ? &items[slot_item[h.slot]] : nullptr; }
+    T const* get(Handle h) const { return alive(h) ? &items[slot_item[h.slot]] : nullptr; }
+
+    Handle handle_at(uint32_t i) const { return Handle { item_slot[i], generation[item_slot[i]] }; }
+
+    // iterate over live entities:
+    T* begin() { return items.data(); }
+    T* end() { return items.data() + count; }
+    T const* begin() const { return items.data(); }
+    T const* end() const { return items.data() + count; }
+
+private:
+    std::array<uint16_t, Capacity> item_slot; // slot of items[i]
+    std::array<uint16_t, Capacity> slot_item; // index into items of the entity in each slot
+    std::array<uint16_t, Capacity> generation; // per slot, bumped on every despawn
+    std::array<uint16_t, Capacity> free_slots; // stack of unused slots
+    uint32_t free_count = Capacity;
+};
@@ -0,0 +1,135 @@
+#include "FileWatcher.hpp"
+
+#include "Log.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define FILE_WATCHER_INOTIFY 1
+#endif
+
+#if FILE_WATCHER_INOTIFY
+
+FileWatcher::FileWatcher(OnChange const& on_change_, uint32_t settle_)
+    : available(true)
+    , on_change(on_change_)
+    , settle(settle_)
+{
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+        throw std::runtime_error(std::string("Failed to start inotify: ") + std::strerror(errno));
+    }
+    stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stop_fd < 0) {
+        close(inotify_fd);
+        throw std::runtime_error(std::string("Failed to make an eventfd: ") + std::strerror(errno));
+    }
+    thread = std::thread(&FileWatcher::run, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+    uint64_t one = 1;
+    if (write(stop_fd, &one, sizeof(one)) != sizeof(one)) {
+        LOG_WARN("FileWatcher failed to signal its thread to stop.");
+    }
+    thread.join();
+    close(stop_fd);
+    close(inotify_fd);
+}
+
+void FileWatcher::watch(std::string const& directory)
+{
+    int wd = inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR);
+    if (wd < 0) {
+        throw std::runtime_error("Failed to watch '" + directory + "': " + std::strerror(errno));
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    directories[wd] = directory;
+}
+
+void FileWatcher::run()
+{
+    // (aligned as the kernel expects, and big enough for several events at once)
+    alignas(struct inotify_event) char buffer[4096];
+    std::vector<std::string> paths;
+
+    pollfd fds[2] = {
+        { inotify_fd, POLLIN, 0 },
+        { stop_fd, POLLIN, 0 },
+    };
+    while (true) {
+        // sleep until something happens, then keep reading until it has been quiet for 'settle' ms:
+        int ready = poll(fds, 2, paths.empty() ? -1 : int(settle));
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("FileWatcher poll failed: " << std::strerror(errno));
+            return;
+        }
+        if (fds[1].revents & POLLIN) {
+            return; // stopping
+        }
+        if (ready == 0) {
+            // quiet; report the batch:
+            try {
+                on_change(paths);
+            } catch (std::exception const& e) {
+                LOG_ERROR("FileWatcher: " << e.what());
+            }
+            batches++;
+            paths.clear();
+            continue;
+        }
+
+        ssize_t length;
+        while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (char const* at = buffer; at < buffer + length;) {
+                auto const* event = reinterpret_cast<struct inotify_event const*>(at);
+                at += sizeof(struct inotify_event) + event->len;
+                auto directory = directories.find(event->wd);
+                if (event->len == 0 || directory == directories.end()) {
+                    continue; // (the directory itself, or a watch that was just removed)
+                }
+                std::string path = directory->second + "/" + event->name;
+                if (std::find(paths.begin(), paths.end(), path) == paths.end()) {
+                    paths.emplace_back(path);
+                }
+            }
+        }
+    }
+}
+
+#else
+
+FileWatcher::FileWatcher(OnChange const& on_change_, uint32_t settle_)
+    : available(false)
+    , on_change(on_change_)
+    , settle(settle_)
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+}
+
+void FileWatcher::watch(std::string const& directory)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    directories[int(directories.size())] = directory;
+}
+
+void FileWatcher::run()
+{
+}
+
+#endif
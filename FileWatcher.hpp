@@ -0,0 +1,56 @@
+#pragma once
+
+/*
+ * FileWatcher -- tells you (on its own thread) which files in some directories were written.
+ *
+ * Built on inotify: the watcher thread sleeps in poll() until files are closed after writing or
+ * moved into a watched directory (editors often save to a temporary file and rename it over the
+ * original), then collects events until none arrive for 'settle' milliseconds, so one save is
+ * reported once, and hands the batch of paths to on_change, still on the watcher thread.
+ *
+ * Paths are reported as "<directory as passed to watch()>/<file name>".
+ *
+ * Where inotify isn't available (anything but Linux) nothing is ever reported, and 'available'
+ * is false.
+ *
+ * Usage:
+ *   FileWatcher watcher([](std::vector<std::string> const& paths) { ... });
+ *   watcher.watch("assets");
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct FileWatcher {
+    typedef std::function<void(std::vector<std::string> const& paths)> OnChange;
+
+    // NOTE: throws if inotify can't be set up
+    FileWatcher(OnChange const& on_change, uint32_t settle = 2);
+    ~FileWatcher(); // (stops and joins the thread; on_change is not called after this returns)
+
+    // start watching a directory (watching one twice is fine):
+    //  NOTE: throws if the directory can't be watched
+    void watch(std::string const& directory);
+
+    const bool available;
+    std::atomic<uint64_t> batches { 0 }; // calls to on_change so far
+
+private:
+    OnChange on_change;
+    const uint32_t settle;
+
+    int inotify_fd = -1;
+    int stop_fd = -1; // written by the destructor to wake the thread
+
+    std::mutex mutex; // guards directories
+    std::unordered_map<int, std::string> directories; // watch descriptor -> directory
+
+    std::thread thread;
+    void run();
+};
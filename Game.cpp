@@ -0,0 +1,439 @@
+#include "Game.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+Game::Game(uint32_t seed_, uint8_t players_, GameConfig const& config_)
+    : GameState(seed_)
+    , seed(seed_)
+    , config(config_)
+{
+    if (config.projectiles > MaxProjectiles || config.targets > MaxTargets || config.super_targets > MaxTargets) {
+        throw std::runtime_error("Game config asks for more projectiles or targets than fit in the entity pools.");
+    }
+    time_left = config.game_length;
+
+    // initialize siphon (player) data, spread evenly across the screen:
+    players = uint8_t(std::max(1, std::min(int(MaxPlayers), int(players_))));
+    for (uint32_t p = 0; p < players; p++) {
+        Siphon& siphon = siphons[p];
+        siphon.speed = config.siphon_speed;
+        siphon.pos.x = float(PPU466::ScreenWidth * (p + 1) / (players + 1));
+        siphon.pos.y = PPU466::ScreenHeight / 2;
+        siphon.prevPos = siphon.pos;
+    }
+
+    for (uint32_t i = 0; i < config.projectiles; i++) {
+        spawn(ProjectileKind);
+    }
+    for (uint32_t i = 0; i < config.targets; i++) {
+        spawn(TargetKind);
+    }
+    // super targets make you wait a bit for their first appearance:
+    for (uint32_t i = 0; i < config.super_targets; i++) {
+        schedule_respawn(SuperTargetKind, float(config.super_target_wait + rng() % std::max(1U, config.super_target_wait_spread)));
+    }
+}
+
+Handle Game::spawn(Kind kind)
+{
+    MovingObject obj;
+    Handle handle;
+    if (kind == ProjectileKind) {
+        obj.speed = config.projectile_speed;
+        obj.randomInit(rng);
+        if (!projectiles.full()) {
+            handle = projectiles.spawn(obj);
+        }
+    } else {
+        auto& pool = (kind == TargetKind ? targets : superTargets);
+        obj.speed = (kind == TargetKind ? config.target_speed : config.super_target_speed);
+        obj.randomInit(rng);
+        if (!pool.full()) {
+            handle = pool.spawn(obj);
+        }
+    }
+    GameEvent event { GameEvent::Spawn };
+    event.kind = kind;
+    event.handle = handle;
+    event.score = score;
+    event.time_left = time_left;
+    event.pos = obj.pos;
+    emit(event);
+    return handle;
+}
+
+Handle Game::schedule_respawn(Kind kind, float delay)
+{
+    return timers.schedule(timers.now + uint32_t(std::ceil(std::max(0.f, delay) * TimerTicksPerSecond)), kind);
+}
+
+void Game::TimersUpdate()
+{
+    const uint32_t now = uint32_t(std::max(0.f, config.game_length - time_left) * TimerTicksPerSecond);
+    timers.advance(now, [this](Kind kind) { spawn(kind); });
+}
+
+uint8_t Game::get_buttons(uint8_t player) const
+{
+    Controls const& c = controls[player];
+    uint8_t bitmask = 0;
+    Button const* buttons[] = { &c.left, &c.right, &c.down, &c.up, &c.aim_left, &c.aim_right, &c.aim_down, &c.aim_up };
+    for (uint32_t i = 0; i < 8; i++) {
+        bitmask |= uint8_t((buttons[i]->pressed ? 1 : 0) << i);
+    }
+    return bitmask;
+}
+
+void Game::set_buttons(uint8_t bitmask, uint8_t player)
+{
+    Controls& c = controls[player];
+    Button* buttons[] = { &c.left, &c.right, &c.down, &c.up, &c.aim_left, &c.aim_right, &c.aim_down, &c.aim_up };
+    for (uint32_t i = 0; i < 8; i++) {
+        buttons[i]->pressed = (bitmask >> i) & 1;
+    }
+}
+
+void Game::PlayerUpdate(float dt)
+{
+    for (uint32_t player = 0; player < players; player++) {
+        Controls const& c = controls[player];
+        Siphon& siphon = siphons[player];
+        if (c.left.pressed) {
+            siphon.vel.x = -siphon.speed;
+        } else if (c.right.pressed) {
+            siphon.vel.x = +siphon.speed;
+        } else {
+            siphon.vel.x = 0;
+        }
+        if (c.down.pressed) {
+            siphon.vel.y = -siphon.speed;
+        } else if (c.up.pressed) {
+            siphon.vel.y = +siphon.speed;
+        } else {
+            siphon.vel.y = 0;
+        }
+        if (c.aim_left.pressed) {
+            siphon.aimDirection = 2;
+        }
+        if (c.aim_right.pressed) {
+            siphon.aimDirection = 0;
+        }
+        if (c.aim_down.pressed) {
+            siphon.aimDirection = 1;
+        }
+        if (c.aim_up.pressed) {
+            siphon.aimDirection = 3;
+        }
+
+        siphon.prevPos = siphon.pos;
+        siphon.pos += dt * siphon.vel;
+
+        siphon.pos.x = std::max(1.f, std::min(float(PPU466::ScreenWidth - 8), siphon.pos.x));
+        siphon.pos.y = std::max(1.f, std::min(float(PPU466::ScreenHeight - 8), siphon.pos.y));
+    }
+}
+
+void Game::ProjectileUpdate(float dt)
+{
+    for (uint32_t i = 0; i < projectiles.count; ++i) {
+        MovingObject& p = projectiles.items[i];
+        p.update(dt, rng);
+        // check for collisions with players (anywhere along this tick's motion); the first to touch it wins:
+        float toi = std::numeric_limits<float>::infinity();
+        uint8_t player = NoPlayer;
+        for (uint32_t s = 0; s < players; s++) {
+            float t = siphons[s].timeOfImpact(p);
+            if (t < toi) {
+                toi = t;
+                player = uint8_t(s);
+            }
+        }
+        if (toi <= 1.f) {
+            if (!p.collision) {
+                // only trigger this effect on the FIRST frame of collision,
+                // redirecting from where the siphon was at the moment of contact:
+                Siphon const& siphon = siphons[player];
+                p.vel = p.speed * p.directionMapping(siphon.aimDirection);
+                p.pos = siphon.posAt(toi) + (1.f - toi) * dt * p.vel;
+                // (so targets see the redirected heading for the whole tick)
+                p.prevPos = p.pos - dt * p.vel;
+                p.owner = player;
+
+                GameEvent event { GameEvent::Redirect };
+                event.kind = ProjectileKind;
+                event.player = player;
+                event.handle = projectiles.handle_at(i);
+                event.score = score;
+                event.time_left = time_left;
+                event.pos = siphon.posAt(toi);
+                emit(event);
+            }
+            p.collision = true;
+        } else {
+            p.collision = false;
+        }
+    }
+}
+
+void Game::BulletsUpdate(float dt)
+{
+    if (pattern) {
+        pattern_player.update(dt, *pattern, siphons[0].pos, &bullets);
+    }
+    bullets.update(dt);
+
+    // check for collisions with players, redirecting only on the FIRST frame of collision:
+    //  (player p uses bits 2p, for touching this tick, and 2p+1, for touching last tick)
+    for (uint32_t i = 0; i < bullets.count; ++i) {
+        bullets.touching[i] = uint8_t((bullets.touching[i] & 0x55) << 1);
+    }
+    for (uint32_t player = 0; player < players; player++) {
+        Siphon const& siphon = siphons[player];
+        const uint8_t touching = uint8_t(3 << (2 * player));
+        bullets.collide(siphon.prevPos, siphon.pos, dt, [&](uint32_t i, float toi) {
+            if (!(bullets.touching[i] & touching)) {
+                const float speed = std::sqrt(bullets.vx[i] * bullets.vx[i] + bullets.vy[i] * bullets.vy[i]);
+                const glm::vec2 vel = speed * MovingObject::directionMapping(siphon.aimDirection);
+                const glm::vec2 pos = siphon.posAt(toi) + (1.f - toi) * dt * vel;
+                bullets.x[i] = pos.x;
+                bullets.y[i] = pos.y;
+                bullets.vx[i] = vel.x;
+                bullets.vy[i] = vel.y;
+                bullets.owner[i] = uint8_t(player);
+
+                GameEvent event { GameEvent::Redirect };
+                event.kind = BulletKind;
+                event.player = uint8_t(player);
+                event.score = score;
+                event.time_left = time_left;
+                event.pos = siphon.posAt(toi);
+                emit(event);
+            }
+            bullets.touching[i] |= uint8_t(1 << (2 * player));
+        });
+    }
+    for (uint32_t i = 0; i < bullets.count; ++i) {
+        bullets.touching[i] &= 0x55;
+    }
+}
+
+void Game::TargetsUpdate(float dt)
+{
+    // a hit despawns both the target and whatever hit it;
+    //  both come back after a while (config.target_respawn, config.projectile_respawn), bullets don't
+    auto update_targets = [&](EntityPool<MovingObject, MaxTargets>& pool, Kind kind, int points) {
+        // (walk backwards, so despawning only ever moves already-updated entities)
+        for (uint32_t ti = pool.count; ti-- > 0;) {
+            MovingObject& t = pool.items[ti];
+            t.update(dt, rng);
+            bool hit = false;
+            uint8_t owner = NoPlayer;
+            for (uint32_t pi = projectiles.count; pi-- > 0 && !hit;) {
+                if (projectiles.items[pi].timeOfImpact(t) <= 1.f) {
+                    owner = projectiles.items[pi].owner;
+                    projectiles.despawn_at(pi);
+                    schedule_respawn(ProjectileKind, config.projectile_respawn);
+                    hit = true;
+                }
+            }
+            if (!hit) {
+                bullets.collide(t.prevPos, t.pos, dt, [&](uint32_t i, float toi) {
+                    if (!hit) {
+                        owner = bullets.owner[i];
+                        bullets.despawn(i);
+                        hit = true;
+                    }
+                });
+            }
+            if (hit) {
+                // (alone, every hit is yours)
+                const uint8_t player = (players == 1 ? 0 : owner);
+                score += points;
+                if (player != NoPlayer) {
+                    scores[player] += points;
+                }
+
+                GameEvent event { GameEvent::Hit };
+                event.kind = kind;
+                event.player = player;
+                event.handle = pool.handle_at(ti);
+                event.points = points;
+                event.score = score;
+                event.time_left = time_left;
+                event.pos = t.pos;
+                emit(event);
+
+                pool.despawn_at(ti);
+                schedule_respawn(kind, config.target_respawn);
+            }
+        }
+    };
+
+    update_targets(targets, TargetKind, int(config.target_points));
+    update_targets(superTargets, SuperTargetKind, int(config.super_target_points)); // super points
+}
+
+void Game::update(float dt)
+{
+    event_count = 0;
+
+    // tick down the game-over timer
+    time_left -= dt;
+
+    if (time_left > 0) {
+        TimersUpdate();
+
+        PlayerUpdate(dt);
+
+        ProjectileUpdate(dt);
+
+        BulletsUpdate(dt);
+
+        TargetsUpdate(dt);
+    } else {
+        if (!end_msg) {
+            GameEvent event { GameEvent::GameOver };
+            event.score = score;
+            event.time_left = time_left;
+            emit(event);
+            end_msg = true;
+        }
+    }
+}
+
+//------------------------------------------------
+
+namespace {
+struct ConfigField {
+    char const* name;
+    float GameConfig::*real;
+    uint32_t GameConfig::*count;
+};
+const ConfigField config_fields[] = {
+    { "game_length", &GameConfig::game_length, nullptr },
+    { "siphon_speed", &GameConfig::siphon_speed, nullptr },
+    { "projectile_speed", &GameConfig::projectile_speed, nullptr },
+    { "target_speed", &GameConfig::target_speed, nullptr },
+    { "super_target_speed", &GameConfig::super_target_speed, nullptr },
+    { "projectiles", nullptr, &GameConfig::projectiles },
+    { "targets", nullptr, &GameConfig::targets },
+    { "super_targets", nullptr, &GameConfig::super_targets },
+    { "target_points", nullptr, &GameConfig::target_points },
+    { "super_target_points", nullptr, &GameConfig::super_target_points },
+    { "projectile_respawn", &GameConfig::projectile_respawn, nullptr },
+    { "target_respawn", &GameConfig::target_respawn, nullptr },
+    { "super_target_wait", nullptr, &GameConfig::super_target_wait },
+    { "super_target_wait_spread", nullptr, &GameConfig::super_target_wait_spread },
+};
+
+ConfigField const& config_field(std::string const& name)
+{
+    for (ConfigField const& field : config_fields) {
+        if (name == field.name) {
+            return field;
+        }
+    }
+    throw std::runtime_error("Unknown game config value '" + name + "'.");
+}
+}
+
+GameConfig GameConfig::load(std::string const& filename)
+{
+    std::ifstream file(filename);
+    if (!file) {
+        throw std::runtime_error("Failed to open game config file '" + filename + "'.");
+    }
+    return parse(file, filename);
+}
+
+GameConfig GameConfig::parse(std::istream& from, std::string const& name)
+{
+    GameConfig config;
+    std::string line;
+    uint32_t line_number = 0;
+    while (std::getline(from, line)) {
+        line_number++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream tokens(line);
+        std::string key, value, extra;
+        if (!(tokens >> key)) {
+            continue; // blank line
+        }
+        if (!(tokens >> value) || (tokens >> extra)) {
+            throw std::runtime_error("Game config '" + name + "' line " + std::to_string(line_number) + ": expecting '<name> <value>'");
+        }
+        config.set(key, value);
+    }
+    return config;
+}
+
+void GameConfig::set(std::string const& name, std::string const& value)
+{
+    ConfigField const& field = config_field(name);
+    size_t used = 0;
+    try {
+        if (field.real) {
+            this->*field.real = std::stof(value, &used);
+        } else {
+            if (!value.empty() && value[0] == '-') {
+                throw std::invalid_argument("negative");
+            }
+            this->*field.count = uint32_t(std::stoul(value, &used));
+        }
+    } catch (std::logic_error const&) {
+        used = 0;
+    }
+    if (used == 0 || used != value.size()) {
+        throw std::runtime_error("Game config value '" + name + "' can't be '" + value + "'.");
+    }
+}
+
+std::string GameConfig::get(std::string const& name) const
+{
+    ConfigField const& field = config_field(name);
+    if (field.real) {
+        std::ostringstream out;
+        out << this->*field.real;
+        return out.str();
+    }
+    return std::to_string(this->*field.count);
+}
+
+std::string GameConfig::to_text() const
+{
+    std::ostringstream out;
+    out.precision(std::numeric_limits<float>::max_digits10);
+    for (ConfigField const& field : config_fields) {
+        out << field.name << ' ';
+        if (field.real) {
+            out << this->*field.real;
+        } else {
+            out << this->*field.count;
+        }
+        out << '\n';
+    }
+    return out.str();
+}
+
+bool GameConfig::operator==(GameConfig const& other) const
+{
+    for (ConfigField const& field : config_fields) {
+        if (field.real ? (this->*field.real != other.*field.real) : (this->*field.count != other.*field.count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::string> GameConfig::names()
+{
+    std::vector<std::string> names;
+    for (ConfigField const& field : config_fields) {
+        names.emplace_back(field.name);
+    }
+    return names;
+}
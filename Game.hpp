@@ -0,0 +1,327 @@
+#pragma once
+
+/*
+ * Game -- the Redirekt simulation, with no dependency on SDL, OpenGL or the PPU.
+ *
+ * PlayMode wraps a Game with input handling and drawing; tools such as the
+ * headless runner drive a Game directly.
+ */
+
+#include "Bullets.hpp"
+#include "EntityPool.hpp"
+#include "PPU466.hpp" // just for the screen dimensions
+#include "TimingWheel.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iosfwd>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Random -- a small, fast random number generator (PCG32).
+//  every Game owns its own, so games can run side-by-side on many threads;
+//  'stream' picks one of 2^63 independent sequences for the same seed.
+struct Random {
+    Random(uint64_t seed, uint64_t stream = 0)
+    {
+        inc = (stream << 1) | 1;
+        (*this)();
+        state += seed;
+        (*this)();
+    }
+
+    uint32_t operator()()
+    {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + inc;
+        uint32_t xorshifted = uint32_t(((old >> 18) ^ old) >> 27);
+        uint32_t rot = uint32_t(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+
+    uint64_t state = 0;
+    uint64_t inc = 1;
+};
+
+struct Object {
+    glm::vec2 pos, vel;
+    glm::vec2 prevPos; // pos at the start of the last tick (for swept collisions)
+    float speed = 30.f;
+
+    // swept collision test:
+    //  treats both objects as 8x8 boxes moving in a straight line from prevPos to pos over the last tick
+    //  and returns the fraction of the tick [0,1] at which they first overlap (infinity if they don't).
+    //  this way fast objects can't skip through each other when the timestep is large.
+    float timeOfImpact(const Object& other) const
+    {
+        const float none = std::numeric_limits<float>::infinity();
+        // motion of the other object relative to this one:
+        const glm::vec2 start = other.prevPos - prevPos;
+        const glm::vec2 delta = (other.pos - pos) - start;
+        float t_enter = 0.f, t_exit = 1.f;
+        for (int axis = 0; axis < 2; axis++) {
+            // the boxes overlap along this axis while |start + t * delta| < 8
+            if (delta[axis] == 0.f) {
+                if (std::abs(start[axis]) >= 8.f) {
+                    return none;
+                }
+                continue;
+            }
+            float t0 = (-8.f - start[axis]) / delta[axis];
+            float t1 = (8.f - start[axis]) / delta[axis];
+            if (t0 > t1) {
+                std::swap(t0, t1);
+            }
+            t_enter = std::max(t_enter, t0);
+            t_exit = std::min(t_exit, t1);
+            if (t_enter >= t_exit) {
+                return none;
+            }
+        }
+        return t_enter;
+    }
+
+    // where this object was at fraction 't' of the last tick:
+    glm::vec2 posAt(float t) const
+    {
+        return prevPos + t * (pos - prevPos);
+    }
+
+    bool atEdge() const
+    {
+        return (pos.x < 0 || pos.y < 0 || pos.x > PPU466::ScreenWidth || pos.y > PPU466::ScreenHeight);
+    }
+
+    void update(float dt)
+    {
+        prevPos = pos;
+        pos += dt * vel;
+    }
+};
+
+struct Siphon : Object {
+    int aimDirection = 0;
+};
+
+// (player index used when no player is responsible for something)
+constexpr uint8_t NoPlayer = 0xff;
+
+struct MovingObject : Object {
+    int wall;
+    bool collision = false;
+    uint8_t owner = NoPlayer; // player who last redirected this
+
+    static glm::vec2 directionMapping(int direction)
+    {
+        if (direction == 0) { // right
+            return glm::vec2(1, 0);
+        } else if (direction == 1) { // bottom
+            return glm::vec2(0, -1);
+        } else if (direction == 2) { // left
+            return glm::vec2(-1, 0);
+        }
+        return glm::vec2(0, 1); // up
+    }
+
+    void update(float dt, Random& rng)
+    {
+        Object::update(dt);
+        // reinitialize the location once they reach the edge
+        if (atEdge()) {
+            randomInit(rng);
+        }
+    }
+
+    void randomInit(Random& rng)
+    {
+        wall = rng() % 4;
+        if (wall == 0) { // right
+            pos.x = PPU466::ScreenWidth - 8;
+            pos.y = int(rng() % PPU466::ScreenHeight) - 8;
+            vel = -speed * directionMapping(0);
+        } else if (wall == 1) { // bottom
+            pos.y = 8;
+            pos.x = int(rng() % PPU466::ScreenHeight) - 8;
+            vel = -speed * directionMapping(1);
+        } else if (wall == 2) { // left
+            pos.x = 8;
+            pos.y = int(rng() % PPU466::ScreenHeight) - 8;
+            vel = -speed * directionMapping(2);
+        } else { // top
+            pos.x = int(rng() % PPU466::ScreenWidth) - 8;
+            pos.y = PPU466::ScreenHeight - 8;
+            vel = -speed * directionMapping(3);
+        }
+        prevPos = pos; // (teleported, so there is no motion to sweep)
+        owner = NoPlayer;
+    }
+};
+
+// GameEvent -- something notable that happened during a Game::update
+struct GameEvent {
+    enum Type : uint8_t {
+        Spawn, // an entity appeared
+        Redirect, // the siphon redirected a projectile or bullet
+        Hit, // a target was hit (and despawned)
+        GameOver, // time ran out
+    } type;
+    uint8_t kind = 0; // Game::Kind of the entity (the target, for Hit)
+    uint8_t player = NoPlayer; // who redirected (Redirect) or gets the points (Hit)
+    Handle handle; // the entity (if it lives in an EntityPool)
+    int points = 0; // points scored (Hit)
+    int score = 0; // score after the event
+    float time_left = 0.f; // when it happened
+    glm::vec2 pos = glm::vec2(0.f, 0.f); // where it happened
+};
+
+// GameConfig -- the balance values, so they can be tuned (and swept) without recompiling.
+struct GameConfig {
+    float game_length = 30.0f; // seconds
+    float siphon_speed = 80.0f; // pixels per second
+    float projectile_speed = 50.0f;
+    float target_speed = 30.0f;
+    float super_target_speed = 20.0f;
+    uint32_t projectiles = 5; // on screen at once
+    uint32_t targets = 3;
+    uint32_t super_targets = 1;
+    uint32_t target_points = 1;
+    uint32_t super_target_points = 5;
+    float projectile_respawn = 2.0f; // seconds from a hit until a replacement appears
+    float target_respawn = 5.0f; // (for super targets too)
+    uint32_t super_target_wait = 3; // the first super targets appear after wait + [0, wait_spread) whole seconds
+    uint32_t super_target_wait_spread = 3;
+
+    // Text format, one value per line, '#' starts a comment:
+    //   <name> <value>
+    // with names as above; values that aren't mentioned keep their defaults.
+    // NOTE: all of these will throw on error
+    static GameConfig load(std::string const& filename);
+    static GameConfig parse(std::istream& from, std::string const& name);
+    void set(std::string const& name, std::string const& value);
+    std::string get(std::string const& name) const;
+
+    static std::vector<std::string> names();
+
+    // every value, in the text format above, with floats written exactly (so parse() gives back an equal config):
+    std::string to_text() const;
+    bool operator==(GameConfig const& other) const;
+    bool operator!=(GameConfig const& other) const { return !(*this == other); }
+};
+
+// GameState -- everything that changes while a game is played, as one trivially copyable block:
+//  snapshotting or restoring a game is a plain copy, with no pointers to fix up.
+//  (so a bot can look ahead and come back, netcode can roll back, and replays can seek)
+struct GameState {
+    GameState(uint32_t seed)
+        : rng(seed)
+    {
+    }
+
+    Random rng; // all the randomness in the game comes from here
+    int score = 0; // (all players together)
+    float time_left = 30.0f; // number of seconds you have to play the game
+    bool end_msg = false;
+
+    // every player has a siphon; in a two-player game hits score for whoever last redirected the projectile:
+    static constexpr uint32_t MaxPlayers = 2;
+    uint8_t players = 1;
+    std::array<Siphon, MaxPlayers> siphons;
+    std::array<int, MaxPlayers> scores = {};
+
+    // entities live in pools; when hit they despawn and a respawn is scheduled:
+    static constexpr uint32_t MaxProjectiles = 32;
+    static constexpr uint32_t MaxTargets = 16;
+    EntityPool<MovingObject, MaxProjectiles> projectiles;
+    EntityPool<MovingObject, MaxTargets> targets;
+    EntityPool<MovingObject, MaxTargets> superTargets;
+
+    enum Kind : uint8_t {
+        ProjectileKind,
+        TargetKind,
+        SuperTargetKind,
+        BulletKind,
+    };
+
+    // spawns that are waiting for their time to come, on a timing wheel of milliseconds since the start
+    //  (so a frame only costs the timers that expire in it):
+    static constexpr uint32_t TimerTicksPerSecond = 1000;
+    static constexpr uint32_t MaxTimers = MaxProjectiles + 2 * MaxTargets;
+    TimingWheel<Kind, MaxTimers> timers;
+
+    PatternPlayer pattern_player;
+    static constexpr uint32_t MaxBullets = 256;
+    BulletPool<MaxBullets> bullets;
+
+    // input:
+    struct Button {
+        uint8_t pressed = 0;
+    };
+    struct Controls {
+        Button left, right, down, up, aim_left, aim_right, aim_down, aim_up;
+    };
+    std::array<Controls, MaxPlayers> controls;
+};
+
+static_assert(std::is_trivially_copyable<GameState>::value, "GameState must be copyable with memcpy");
+
+struct Game : GameState {
+    // NOTE: throws if 'config' asks for more entities than the pools hold
+    Game(uint32_t seed, uint8_t players = 1, GameConfig const& config = GameConfig());
+
+    // advance the simulation by 'dt' seconds:
+    void update(float dt);
+
+    const uint32_t seed; // what the random number generator was seeded with
+    const GameConfig config;
+
+    bool over() const { return time_left <= 0; }
+
+    //----- snapshots -----
+    // (events, the config and the pattern are not part of the state; the pattern must outlive any snapshot use)
+    GameState const& state() const { return *this; }
+    void restore(GameState const& state) { static_cast<GameState&>(*this) = state; }
+
+    //----- updates -----
+    void PlayerUpdate(float dt);
+
+    void ProjectileUpdate(float dt);
+
+    void TargetsUpdate(float dt);
+
+    Handle spawn(Kind kind); // (at a random wall)
+    Handle schedule_respawn(Kind kind, float delay); // (Handle() if there are too many timers)
+    void TimersUpdate();
+
+    //----- bullet patterns -----
+    // if a pattern is set, its bullets fly alongside the regular projectiles:
+    //  they are redirected by the siphon and score on targets in just the same way
+    Pattern const* pattern = nullptr;
+    void BulletsUpdate(float dt);
+
+    //----- events -----
+    // everything notable that happened during the last update (cleared at the start of every update):
+    //  consumers such as the score display, logging, telemetry or audio read these once update returns,
+    //  so the simulation itself never formats text or does I/O.
+    static constexpr uint32_t MaxEvents = 256;
+    std::array<GameEvent, MaxEvents> events;
+    uint32_t event_count = 0;
+    uint32_t events_dropped = 0; // events that didn't fit (over the whole game)
+    void emit(GameEvent const& event)
+    {
+        if (event_count < MaxEvents) {
+            events[event_count++] = event;
+        } else {
+            events_dropped++;
+        }
+    }
+
+    //----- input -----
+    // pack/unpack a player's Controls into a bitmask (one bit per Button, in declaration order):
+    uint8_t get_buttons(uint8_t player = 0) const;
+    void set_buttons(uint8_t bitmask, uint8_t player = 0);
+};
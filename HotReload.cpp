@@ -0,0 +1,107 @@
+#include "HotReload.hpp"
+
+#include "Log.hpp"
+
+#include <unordered_set>
+
+// paths as FileWatcher reports them: "<directory>/<file name>"
+static std::string directory_of(std::string const& path)
+{
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? "." : path.substr(0, slash);
+}
+
+static std::string watched_path(std::string const& path)
+{
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? "./" + path : path;
+}
+
+SpriteHotReload::SpriteHotReload(std::string const& list_file, std::string const& root)
+    : list(std::make_unique<SpriteList>(list_file, root))
+    , watcher([this](std::vector<std::string> const& paths) { changed(paths); })
+{
+    if (!watcher.available) {
+        LOG_WARN("Hot reload isn't available on this platform; sprites will not be reloaded.");
+        return;
+    }
+    std::lock_guard<std::mutex> lock(list_mutex);
+    watch_directories();
+    LOG_INFO("Hot reload: watching '" << list->filename << "' and " << list->entries.size() << " sprites.");
+}
+
+void SpriteHotReload::watch_directories()
+{
+    std::unordered_set<std::string> directories { directory_of(list->filename) };
+    for (SpriteList::Entry const& entry : list->entries) {
+        directories.emplace(directory_of(list->png_path(entry)));
+    }
+    for (std::string const& directory : directories) {
+        watcher.watch(directory);
+    }
+}
+
+std::shared_ptr<Sprites const> SpriteHotReload::take()
+{
+    std::shared_ptr<Sprites const> ret;
+    std::chrono::steady_clock::time_point when;
+    {
+        std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+        if (!lock.owns_lock() || !pending) {
+            return nullptr; // (nothing new, or the watcher is publishing right now; try next frame)
+        }
+        ret = std::move(pending);
+        when = noticed;
+    }
+    reloads++;
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - when).count();
+    LOG_INFO("Hot reload: new sprites taken " << us << " us after the change was noticed.");
+    return ret;
+}
+
+void SpriteHotReload::changed(std::vector<std::string> const& paths)
+{
+    auto before = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> list_lock(list_mutex);
+    std::unordered_set<std::string> touched(paths.begin(), paths.end());
+
+    bool list_changed = touched.count(watched_path(list->filename)) > 0;
+    if (list_changed) {
+        try {
+            list = std::make_unique<SpriteList>(list->filename, list->root);
+            watch_directories(); // (in case a sprite now comes from somewhere new)
+        } catch (std::exception const& e) {
+            LOG_ERROR("Hot reload: keeping the old sprite list: " << e.what());
+            return;
+        }
+    }
+
+    Sprites sprites;
+    uint32_t reconverted = 0;
+    for (SpriteList::Entry const& entry : list->entries) {
+        auto found = converted.find(entry.name);
+        if (found == converted.end() || !(found->second.entry == entry) || touched.count(watched_path(list->png_path(entry)))) {
+            Converted fresh;
+            fresh.entry = entry;
+            try {
+                list->convert(entry, &fresh.tiles, &fresh.palette);
+            } catch (std::exception const& e) {
+                LOG_ERROR("Hot reload: keeping the old sprites: " << e.what());
+                return;
+            }
+            found = converted.insert_or_assign(entry.name, std::move(fresh)).first;
+            reconverted++;
+        }
+        sprites.add(entry.name, found->second.tiles, found->second.palette);
+    }
+    if (reconverted == 0 && !list_changed) {
+        return; // (something else in a watched directory changed)
+    }
+
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - before).count();
+    LOG_INFO("Hot reload: converted " << reconverted << " of " << list->entries.size() << " sprites in " << us << " us.");
+
+    std::lock_guard<std::mutex> lock(mutex);
+    pending = std::make_shared<Sprites const>(std::move(sprites));
+    noticed = before;
+}
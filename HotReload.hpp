@@ -0,0 +1,63 @@
+#pragma once
+
+/*
+ * SpriteHotReload -- converts sprites again whenever their PNGs or the sprite list change on disk,
+ * so art and colour banks can be iterated on while the game runs (dist/game --hot-reload).
+ *
+ * A FileWatcher (inotify) notices saves to the list or to any PNG it names. On the watcher's
+ * thread the list is re-read if it changed, and just the sprites whose PNG or list line changed are
+ * decoded and converted again (SpriteList::convert); everything else is reused from the last
+ * reload. The result is a complete Sprites, handed over through take(), which the game loop calls
+ * between frames and which never waits on a conversion.
+ *
+ * Errors (a malformed list, a half-written PNG) are logged and the last good sprites kept.
+ *
+ * Usage:
+ *   SpriteHotReload reload(data_path("../assets/sprites.txt"), data_path(".."));
+ *   if (std::shared_ptr<Sprites const> fresh = reload.take()) { ... copy into the PPU ... }
+ */
+
+#include "FileWatcher.hpp"
+#include "SpriteList.hpp"
+#include "Sprites.hpp"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct SpriteHotReload {
+    // 'list_file' as read by dist/pack-sprites, PNG paths in it relative to 'root':
+    //  NOTE: throws if the list can't be read or its directories can't be watched
+    SpriteHotReload(std::string const& list_file, std::string const& root);
+
+    // the newest sprites, if they changed since the last call (otherwise nullptr):
+    std::shared_ptr<Sprites const> take();
+
+    uint32_t reloads = 0; // sprites handed out by take()
+
+private:
+    // (the rest runs on the watcher thread)
+    void changed(std::vector<std::string> const& paths);
+    void watch_directories();
+
+    std::mutex list_mutex; // guards list + converted (only contended while the constructor adds watches)
+    std::unique_ptr<SpriteList> list;
+
+    // the last conversion of every sprite, by name:
+    struct Converted {
+        SpriteList::Entry entry;
+        std::vector<PPU466::Tile> tiles;
+        PPU466::Palette palette;
+    };
+    std::unordered_map<std::string, Converted> converted;
+
+    std::mutex mutex; // guards pending + noticed
+    std::shared_ptr<Sprites const> pending;
+    std::chrono::steady_clock::time_point noticed; // when the change behind 'pending' was reported
+
+    // (last, so its thread is stopped before anything above goes away)
+    FileWatcher watcher;
+};
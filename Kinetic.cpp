@@ -0,0 +1,324 @@
+#include "Kinetic.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+static const float Never = std::numeric_limits<float>::infinity();
+
+// the times [enter, exit), relative to now, during which 8x8 boxes 'start' apart with relative velocity 'delta'
+//  overlap (enter <= 0 means they already do); returns false if they don't overlap at any time from now on:
+//  (the same slab test as Object::timeOfImpact, over unbounded time)
+static bool overlap(glm::vec2 start, glm::vec2 delta, float* enter, float* exit)
+{
+    float t_enter = -Never, t_exit = Never;
+    for (int axis = 0; axis < 2; axis++) {
+        if (delta[axis] == 0.f) {
+            if (std::abs(start[axis]) >= 8.f) {
+                return false;
+            }
+            continue;
+        }
+        float t0 = (-8.f - start[axis]) / delta[axis];
+        float t1 = (8.f - start[axis]) / delta[axis];
+        t_enter = std::max(t_enter, std::min(t0, t1));
+        t_exit = std::min(t_exit, std::max(t0, t1));
+    }
+    *enter = t_enter;
+    *exit = t_exit;
+    return t_enter < t_exit && t_exit > 0.f;
+}
+
+// time from now until something at 'pos' moving at 'vel' is past the edge of the screen (as in Object::atEdge):
+static float exit_time(glm::vec2 pos, glm::vec2 vel)
+{
+    const glm::vec2 size = glm::vec2(PPU466::ScreenWidth, PPU466::ScreenHeight);
+    float t = Never;
+    for (int axis = 0; axis < 2; axis++) {
+        if (pos[axis] < 0.f || pos[axis] > size[axis]) {
+            return 0.f;
+        }
+        if (vel[axis] < 0.f) {
+            t = std::min(t, -pos[axis] / vel[axis]);
+        } else if (vel[axis] > 0.f) {
+            t = std::min(t, (size[axis] - pos[axis]) / vel[axis]);
+        }
+    }
+    return t;
+}
+
+// the box siphons are kept inside (as in Game::PlayerUpdate):
+static const glm::vec2 SiphonMin = glm::vec2(1.f, 1.f);
+static const glm::vec2 SiphonMax = glm::vec2(PPU466::ScreenWidth - 8, PPU466::ScreenHeight - 8);
+
+KineticGame::KineticGame(uint32_t seed_, uint8_t players_, GameConfig const& config_)
+    : seed(seed_)
+    , config(config_)
+    , players(uint8_t(std::max(1, std::min(int(GameState::MaxPlayers), int(players_)))))
+    , rng(seed_)
+{
+    first_projectile = players;
+    first_target = uint16_t(first_projectile + config.projectiles);
+    end_movers = uint16_t(first_target + config.targets + config.super_targets);
+    movers.resize(end_movers);
+
+    for (uint16_t s = 0; s < players; s++) {
+        Mover& siphon = movers[s];
+        siphon.kind = SiphonKind;
+        siphon.speed = config.siphon_speed;
+        siphon.p0 = glm::vec2(float(PPU466::ScreenWidth * (s + 1) / (players + 1)), PPU466::ScreenHeight / 2);
+        siphon.alive = true;
+    }
+    for (uint16_t m = first_projectile; m < end_movers; m++) {
+        Mover& mover = movers[m];
+        if (m < first_target) {
+            mover.kind = ProjectileKind;
+            mover.speed = config.projectile_speed;
+        } else if (m < first_target + config.targets) {
+            mover.kind = TargetKind;
+            mover.speed = config.target_speed;
+        } else {
+            mover.kind = SuperTargetKind;
+            mover.speed = config.super_target_speed;
+        }
+    }
+
+    // (same order of random numbers as Game, so games start out the same)
+    for (uint16_t m = first_projectile; m < first_target + config.targets; m++) {
+        spawn(m);
+    }
+    for (uint16_t m = uint16_t(first_target + config.targets); m < end_movers; m++) {
+        push(float(config.super_target_wait + rng() % std::max(1U, config.super_target_wait_spread)), Event::Respawn, m);
+    }
+}
+
+glm::vec2 KineticGame::siphon_pos(uint8_t player) const
+{
+    return movers[player].at(now);
+}
+
+void KineticGame::update(float dt)
+{
+    stats.ticks++;
+    const double end = now + dt;
+
+    for (uint16_t s = 0; s < players; s++) {
+        // (later aim buttons win, as in Game::PlayerUpdate)
+        const uint8_t b = buttons[s];
+        Mover& siphon = movers[s];
+        siphon.aim = (b & (1 << 4)) ? 2 : siphon.aim;
+        siphon.aim = (b & (1 << 5)) ? 0 : siphon.aim;
+        siphon.aim = (b & (1 << 6)) ? 1 : siphon.aim;
+        siphon.aim = (b & (1 << 7)) ? 3 : siphon.aim;
+        steer(s);
+    }
+
+    while (!queue.empty() && queue.front().time <= end) {
+        std::pop_heap(queue.begin(), queue.end(), std::greater<Event>());
+        Event event = queue.back();
+        queue.pop_back();
+        if (stale(event)) {
+            stats.stale++;
+            continue;
+        }
+        stats.events++;
+        now = std::max(now, event.time);
+        handle(event);
+    }
+    now = end;
+
+    // every change leaves its old predictions behind; now and then, clear them out:
+    if (queue.size() > compact_at) {
+        queue.erase(std::remove_if(queue.begin(), queue.end(), [this](Event const& e) { return stale(e); }), queue.end());
+        std::make_heap(queue.begin(), queue.end(), std::greater<Event>());
+        compact_at = std::max<size_t>(1024, 2 * queue.size());
+    }
+}
+
+void KineticGame::push(double time, Event::Type type, uint16_t a, uint16_t b)
+{
+    const bool pair = (type == Event::Touch || type == Event::Separate || type == Event::Hit);
+    queue.emplace_back(Event { time, type, a, b, movers[a].version, pair ? movers[b].version : 0 });
+    std::push_heap(queue.begin(), queue.end(), std::greater<Event>());
+}
+
+bool KineticGame::stale(Event const& event) const
+{
+    const bool pair = (event.type == Event::Touch || event.type == Event::Separate || event.type == Event::Hit);
+    return event.version_a != movers[event.a].version || (pair && event.version_b != movers[event.b].version);
+}
+
+void KineticGame::handle(Event const& event)
+{
+    if (event.type == Event::Respawn || event.type == Event::Exit) {
+        spawn(event.a);
+    } else if (event.type == Event::Stop) {
+        steer(event.a);
+    } else if (event.type == Event::Touch) {
+        // redirect from where the siphon is, as in Game::ProjectileUpdate:
+        Mover const& siphon = movers[event.a];
+        Mover& p = movers[event.b];
+        p.p0 = siphon.at(now);
+        p.t0 = now;
+        p.v = p.speed * MovingObject::directionMapping(siphon.aim);
+        p.owner = uint8_t(event.a);
+        p.contact |= uint8_t(1 << event.a);
+        redirects++;
+        changed(event.b);
+    } else if (event.type == Event::Separate) {
+        movers[event.b].contact &= uint8_t(~(1 << event.a));
+    } else if (event.type == Event::Hit) {
+        // (alone, every hit is yours)
+        const uint8_t player = (players == 1 ? 0 : movers[event.b].owner);
+        const int points = int(movers[event.a].kind == TargetKind ? config.target_points : config.super_target_points);
+        score += points;
+        if (player != NoPlayer) {
+            scores[player] += points;
+        }
+        hits++;
+        despawn(event.b, config.projectile_respawn);
+        despawn(event.a, config.target_respawn);
+    }
+}
+
+void KineticGame::changed(uint16_t m)
+{
+    movers[m].version++;
+    predict(m);
+}
+
+void KineticGame::predict(uint16_t m)
+{
+    Mover const& mover = movers[m];
+    if (!mover.alive) {
+        return;
+    }
+    const glm::vec2 pos = mover.at(now);
+    if (mover.kind == SiphonKind) {
+        float t = Never;
+        for (int axis = 0; axis < 2; axis++) {
+            if (mover.v[axis] < 0.f) {
+                t = std::min(t, (SiphonMin[axis] - pos[axis]) / mover.v[axis]);
+            } else if (mover.v[axis] > 0.f) {
+                t = std::min(t, (SiphonMax[axis] - pos[axis]) / mover.v[axis]);
+            }
+        }
+        if (t != Never) {
+            push(now + std::max(0.f, t), Event::Stop, m);
+        }
+        for (uint16_t p = first_projectile; p < first_target; p++) {
+            predict_pair(m, p);
+        }
+        return;
+    }
+
+    stats.predictions++;
+    float t = exit_time(pos, mover.v);
+    if (t != Never) {
+        push(now + t, Event::Exit, m);
+    }
+    if (mover.kind == ProjectileKind) {
+        for (uint16_t s = 0; s < players; s++) {
+            predict_pair(s, m);
+        }
+        for (uint16_t target = first_target; target < end_movers; target++) {
+            predict_pair(target, m);
+        }
+    } else {
+        for (uint16_t p = first_projectile; p < first_target; p++) {
+            predict_pair(m, p);
+        }
+    }
+}
+
+void KineticGame::predict_pair(uint16_t a, uint16_t p)
+{
+    Mover const& other = movers[a];
+    Mover& projectile = movers[p];
+    if (!other.alive || !projectile.alive) {
+        return;
+    }
+    stats.predictions++;
+    float enter = Never, exit = Never;
+    const bool overlaps = overlap(projectile.at(now) - other.at(now), projectile.v - other.v, &enter, &exit);
+    if (other.kind != SiphonKind) {
+        if (overlaps) {
+            push(now + std::max(0.f, enter), Event::Hit, a, p);
+        }
+        return;
+    }
+
+    // a siphon only redirects a projectile when they first touch, so keep track of touching:
+    const uint8_t bit = uint8_t(1 << a);
+    if (overlaps && enter <= 0.f) {
+        if (projectile.contact & bit) {
+            if (exit != Never) {
+                push(now + exit, Event::Separate, a, p);
+            }
+        } else {
+            push(now, Event::Touch, a, p);
+        }
+        return;
+    }
+    projectile.contact &= uint8_t(~bit);
+    if (overlaps) {
+        push(now + enter, Event::Touch, a, p);
+    }
+}
+
+void KineticGame::spawn(uint16_t m)
+{
+    Mover& mover = movers[m];
+    MovingObject obj;
+    obj.speed = mover.speed;
+    obj.randomInit(rng);
+    mover.p0 = obj.pos;
+    mover.v = obj.vel;
+    mover.t0 = now;
+    mover.alive = true;
+    mover.owner = NoPlayer;
+    mover.contact = 0;
+    changed(m);
+}
+
+void KineticGame::despawn(uint16_t m, float respawn_delay)
+{
+    movers[m].alive = false;
+    movers[m].version++;
+    push(now + respawn_delay, Event::Respawn, m);
+}
+
+glm::vec2 KineticGame::siphon_velocity(uint16_t s) const
+{
+    const uint8_t b = buttons[s];
+    Mover const& siphon = movers[s];
+    glm::vec2 v = glm::vec2(0.f);
+    v.x = (b & (1 << 0)) ? -siphon.speed : (b & (1 << 1)) ? siphon.speed : 0.f;
+    v.y = (b & (1 << 2)) ? -siphon.speed : (b & (1 << 3)) ? siphon.speed : 0.f;
+    return v;
+}
+
+void KineticGame::steer(uint16_t s)
+{
+    Mover& siphon = movers[s];
+    glm::vec2 pos = siphon.at(now);
+    glm::vec2 v = siphon_velocity(s);
+    // (stopped by the edges of the screen; the small margin absorbs rounding in at())
+    for (int axis = 0; axis < 2; axis++) {
+        if (pos[axis] <= SiphonMin[axis] + 1e-3f && v[axis] <= 0.f) {
+            pos[axis] = SiphonMin[axis];
+            v[axis] = std::max(0.f, v[axis]);
+        }
+        if (pos[axis] >= SiphonMax[axis] - 1e-3f && v[axis] >= 0.f) {
+            pos[axis] = SiphonMax[axis];
+            v[axis] = std::min(0.f, v[axis]);
+        }
+    }
+    if (v == siphon.v) {
+        return; // (still moving in a straight line, so nothing predicted has changed)
+    }
+    siphon.p0 = pos;
+    siphon.t0 = now;
+    siphon.v = v;
+    changed(s);
+}
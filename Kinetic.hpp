@@ -0,0 +1,123 @@
+#pragma once
+
+/*
+ * KineticGame -- an event-driven version of the Game simulation.
+ *
+ * Between redirects everything moves in a straight line at constant velocity (the siphons too,
+ * between input changes), so instead of moving and testing every entity every tick, KineticGame
+ * stores each entity as (p0, v, t0), evaluates positions only when needed, and predicts when
+ * something will next happen to it:
+ *  - leaving the screen (and coming back in at a random wall),
+ *  - a siphon touching a projectile (redirect) and separating from it again,
+ *  - a projectile overlapping a target (hit),
+ *  - a siphon reaching the edge of the screen (stop),
+ *  - a despawned entity respawning.
+ * Those events wait in a priority queue; update(dt) just handles whatever falls due during the tick,
+ * so the cost follows the rate of events rather than the number of entities times the frame rate.
+ *
+ * When an entity's motion changes, its version is bumped and its events are predicted again;
+ * queued events that name an older version are simply dropped when they come up.
+ *
+ * The rules are those of Game (same GameConfig, same scoring), but events happen at their exact
+ * times rather than at tick boundaries, so games are not tick-for-tick identical to Game.
+ * Bullet patterns and GameEvents are not supported.
+ *
+ * Usage (like Game):
+ *   KineticGame game(seed);
+ *   while (!game.over()) {
+ *       game.set_buttons(input);
+ *       game.update(dt);
+ *   }
+ */
+
+#include "Game.hpp"
+
+#include <cstdint>
+#include <vector>
+
+struct KineticGame {
+    KineticGame(uint32_t seed, uint8_t players = 1, GameConfig const& config = GameConfig());
+
+    void update(float dt);
+    bool over() const { return time_left() <= 0.0f; }
+    float time_left() const { return config.game_length - float(now); }
+
+    // bits as in Game::set_buttons:
+    void set_buttons(uint8_t bitmask, uint8_t player = 0) { buttons[player] = bitmask; }
+
+    // position of siphon 'player' right now:
+    glm::vec2 siphon_pos(uint8_t player) const;
+
+    const uint32_t seed;
+    const GameConfig config;
+    const uint8_t players;
+
+    Random rng;
+    int score = 0; // (all players)
+    std::array<int, GameState::MaxPlayers> scores = {};
+    uint32_t hits = 0;
+    uint32_t redirects = 0;
+
+    struct Stats {
+        uint64_t ticks = 0;
+        uint64_t events = 0; // events handled
+        uint64_t stale = 0; // events dropped because something changed since they were predicted
+        uint64_t predictions = 0; // pairs/edges checked
+    } stats;
+
+private:
+    enum Kind : uint8_t { SiphonKind, ProjectileKind, TargetKind, SuperTargetKind };
+
+    struct Mover {
+        glm::vec2 p0 = glm::vec2(0.f), v = glm::vec2(0.f); // position at time t0, and velocity
+        double t0 = 0.0;
+        float speed = 0.f;
+        uint32_t version = 0; // bumped whenever p0/v change or it (de)spawns
+        Kind kind = SiphonKind;
+        bool alive = false;
+        uint8_t owner = NoPlayer; // (projectiles) player who last redirected it
+        uint8_t contact = 0; // (projectiles) bit per siphon currently touching it since a redirect
+        int aim = 0; // (siphons) aim direction
+
+        glm::vec2 at(double t) const { return p0 + float(t - t0) * v; }
+    };
+
+    struct Event {
+        enum Type : uint8_t {
+            // (in order of precedence when two happen at the same time)
+            Respawn, // a: mover to respawn
+            Stop, // a: siphon reaching the edge of the screen
+            Touch, // a: siphon, b: projectile
+            Separate, // a: siphon, b: projectile
+            Hit, // a: target, b: projectile
+            Exit, // a: projectile or target leaving the screen
+        };
+        double time;
+        Type type;
+        uint16_t a, b;
+        uint32_t version_a, version_b;
+
+        bool operator>(Event const& other) const { return time != other.time ? time > other.time : type > other.type; }
+    };
+
+    double now = 0.0;
+    std::array<uint8_t, GameState::MaxPlayers> buttons = {};
+    std::vector<Mover> movers; // siphons, then projectiles, then targets, then super targets
+    uint16_t first_projectile = 0, first_target = 0, end_movers = 0;
+    std::vector<Event> queue; // (a heap, earliest first)
+    size_t compact_at = 1024; // queue size at which stale events get cleared out
+
+    void push(double time, Event::Type type, uint16_t a, uint16_t b = 0);
+    bool stale(Event const& event) const;
+    void handle(Event const& event);
+
+    // after a mover's p0/v changed (or it (re)spawned): bump its version and predict its events again:
+    void changed(uint16_t m);
+    void predict(uint16_t m);
+    void predict_pair(uint16_t siphon_or_target, uint16_t projectile);
+
+    void spawn(uint16_t m); // (at a random wall)
+    void despawn(uint16_t m, float respawn_delay);
+    glm::vec2 siphon_velocity(uint16_t s) const;
+    void steer(uint16_t s); // (apply the current buttons)
+};
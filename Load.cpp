@@ -1,20 +1,64 @@
 #include "Load.hpp"
 
+#include "Log.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
 #include <array>
 #include <list>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace {
-	std::array< std::list< std::function< void() > >, MaxLoadTag > &get_load_lists() {
-		static std::array< std::list< std::function< void() > >, MaxLoadTag > load_lists;
+	struct LoadJob {
+		LoadTag tag;
+		LoadStages stages;
+		bool plain = false; //added with add_load_function(), so waits on every earlier load with its tag
+		std::vector< LoadJob * > dependents; //loads (of the same tag) waiting on this one
+		uint32_t waiting = 0; //unfinished loads this one is waiting on
+		std::exception_ptr error; //set if the cpu stage threw
+		//timeline, in milliseconds since call_load_functions() started (-1 if the stage doesn't exist):
+		double cpu_begin = -1.0, cpu_end = -1.0;
+		double gl_begin = -1.0, gl_end = -1.0;
+	};
+
+	//(a list, so jobs stay put as more are added)
+	std::array< std::list< LoadJob >, MaxLoadTag > &get_load_lists() {
+		static std::array< std::list< LoadJob >, MaxLoadTag > load_lists;
 		return load_lists;
 	}
+
+	char const *tag_name(LoadTag tag) {
+		if (tag == LoadTagEarly) return "early";
+		if (tag == LoadTagDefault) return "default";
+		if (tag == LoadTagLate) return "late";
+		return "?";
+	}
 }
 
 void add_load_function(LoadTag tag, std::function< void() > const &fn) {
+	LoadStages stages;
+	stages.gl = fn;
+	add_load_stages(tag, stages);
+	get_load_lists()[tag].back().plain = true;
+}
+
+void add_load_stages(LoadTag tag, LoadStages const &stages) {
 	auto &load_lists = get_load_lists();
 	assert(tag < load_lists.size());
-	load_lists[tag].emplace_back(fn);
+	load_lists[tag].emplace_back();
+	load_lists[tag].back().tag = tag;
+	load_lists[tag].back().stages = stages;
+	if (load_lists[tag].back().stages.name.empty()) {
+		load_lists[tag].back().stages.name = std::string(tag_name(tag)) + " #" + std::to_string(load_lists[tag].size());
+	}
 }
 
 void call_load_functions() {
@@ -22,11 +66,151 @@ void call_load_functions() {
 	assert(!has_been_called && "call_load_functions should only be called *once*");
 	has_been_called = true;
 
+	auto start = std::chrono::high_resolution_clock::now();
+	auto ms = [&start]() {
+		return std::chrono::duration< double, std::milli >(std::chrono::high_resolution_clock::now() - start).count();
+	};
+
 	auto &load_lists = get_load_lists();
+
+	//hook up dependencies:
+	std::unordered_map< std::string, LoadJob * > by_name;
+	for (auto &fn_list : load_lists) {
+		for (auto &job : fn_list) {
+			if (!by_name.emplace(job.stages.name, &job).second) {
+				throw std::runtime_error("Two loads are named '" + job.stages.name + "'.");
+			}
+		}
+	}
+	bool any_cpu = false;
 	for (auto &fn_list : load_lists) {
-		while (!fn_list.empty()) {
-			(*fn_list.begin())(); //call first function in the list
-			fn_list.pop_front(); //remove from list
+		for (auto &job : fn_list) {
+			any_cpu = any_cpu || bool(job.stages.cpu);
+			if (job.plain) {
+				//plain loads keep registration order: everything added before them (with this tag) finishes first
+				for (auto &earlier : fn_list) {
+					if (&earlier == &job) break;
+					earlier.dependents.emplace_back(&job);
+					job.waiting += 1;
+				}
+			}
+			for (auto const &name : job.stages.after) {
+				auto found = by_name.find(name);
+				if (found == by_name.end()) {
+					throw std::runtime_error("Load '" + job.stages.name + "' comes after '" + name + "', which doesn't exist.");
+				}
+				LoadJob *dep = found->second;
+				if (dep->tag > job.tag) {
+					throw std::runtime_error("Load '" + job.stages.name + "' comes after '" + name + "', which has a later tag.");
+				}
+				if (dep->tag == job.tag) { //(loads with earlier tags are done by the time this tag starts)
+					dep->dependents.emplace_back(&job);
+					job.waiting += 1;
+				}
+			}
+		}
+	}
+
+	//cpu stages run on the pool; everything comes back to the main thread (in 'finished') for its gl stage:
+	std::unique_ptr< ThreadPool > pool;
+	if (any_cpu) pool = std::make_unique< ThreadPool >();
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::deque< LoadJob * > finished;
+
+	auto begin = [&](LoadJob *job) {
+		if (job->stages.cpu) {
+			pool->push([&, job](){
+				job->cpu_begin = ms();
+				try {
+					job->stages.cpu();
+				} catch (...) {
+					job->error = std::current_exception();
+				}
+				job->cpu_end = ms();
+				{
+					std::lock_guard< std::mutex > lock(mutex);
+					finished.emplace_back(job);
+				}
+				cv.notify_one();
+			});
+		} else {
+			std::lock_guard< std::mutex > lock(mutex);
+			finished.emplace_back(job);
+		}
+	};
+
+	try {
+		for (auto &fn_list : load_lists) {
+			size_t started = 0;
+			size_t done = 0;
+			for (auto &job : fn_list) {
+				if (job.waiting == 0) {
+					begin(&job);
+					started += 1;
+				}
+			}
+			while (done < fn_list.size()) {
+				if (started == done) {
+					throw std::runtime_error("Loads with tag '" + std::string(tag_name(fn_list.front().tag)) + "' wait on each other in a cycle.");
+				}
+				LoadJob *job;
+				{
+					std::unique_lock< std::mutex > lock(mutex);
+					cv.wait(lock, [&finished](){ return !finished.empty(); });
+					job = finished.front();
+					finished.pop_front();
+				}
+				if (job->error) std::rethrow_exception(job->error);
+				if (job->stages.gl) {
+					job->gl_begin = ms();
+					job->stages.gl();
+					job->gl_end = ms();
+				}
+				done += 1;
+				for (LoadJob *dependent : job->dependents) {
+					dependent->waiting -= 1;
+					if (dependent->waiting == 0) {
+						begin(dependent);
+						started += 1;
+					}
+				}
+			}
+		}
+	} catch (...) {
+		//(cpu stages still running refer to the locals above)
+		if (pool) pool->wait();
+		throw;
+	}
+
+	//startup timeline:
+	double total = ms();
+	size_t count = 0;
+	for (auto const &fn_list : load_lists) count += fn_list.size();
+	if (pool) {
+		LOG_INFO("Loaded " << count << " assets in " << total << " ms (" << pool->size() << " worker threads):");
+	} else {
+		LOG_INFO("Loaded " << count << " assets in " << total << " ms:");
+	}
+	const uint32_t Width = 40; //columns in the timeline bars
+	for (auto const &fn_list : load_lists) {
+		for (auto const &job : fn_list) {
+			//'-' for the cpu stage, '#' for the gl stage:
+			std::string bar(Width, ' ');
+			auto mark = [&](double from, double to, char c) {
+				if (from < 0.0) return;
+				uint32_t a = uint32_t(from / total * Width);
+				uint32_t b = std::max(a + 1, uint32_t(to / total * Width));
+				for (uint32_t i = a; i < b && i < Width; ++i) bar[i] = c;
+			};
+			mark(job.cpu_begin, job.cpu_end, '-');
+			mark(job.gl_begin, job.gl_end, '#');
+			char line[128];
+			std::snprintf(line, sizeof(line), "  %-7s %-20s |%s| cpu %7.2f ms, gl %7.2f ms",
+				tag_name(job.tag), job.stages.name.c_str(), bar.c_str(),
+				job.cpu_end - job.cpu_begin, job.gl_end - job.gl_begin);
+			LOG_INFO(line);
 		}
 	}
 }
@@ -20,10 +20,26 @@
  * These functions are grouped by 'tags', which allow some sequencing of calls.
  * (particularly, this is useful for loading large data blobs [e.g. Meshes] before looking up individual elements within them.)
  *
+ * A load may also be split into stages (see add_load_stages()):
+ *  - a 'cpu' stage (reading files, decoding, converting) runs on a pool of worker threads and must not touch OpenGL;
+ *  - a 'gl' stage (creating buffers, uploading textures) runs afterward on the main thread.
+ * Loads with the same tag run in parallel, except where one names another in its 'after' list.
+ * Plain loads (add_load_function(), or a Load<> without a name) keep the old ordering: each waits for
+ * every load registered before it with the same tag -- staged ones included -- to finish completely.
+ * Every tag still finishes completely before the next one starts.
+ *
+ * //at global scope:
+ * Load< Sprites > sprites(LoadTagDefault, "sprites", []() -> Sprites const * {
+ *     return new Sprites(data_path("redirekt.sprites")); //runs on a worker thread
+ * });
+ *
  */
 
+#include <cstdint>
 #include <functional>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 enum LoadTag : uint32_t {
 	LoadTagEarly,
@@ -34,11 +50,26 @@ enum LoadTag : uint32_t {
 
 //Add a function to an internal list of loading functions:
 // (only call *before* "call_load_functions()")
+// (the function runs on the main thread, so may use OpenGL)
+// (it runs after every load added earlier with the same tag has finished)
 void add_load_function(LoadTag tag, std::function< void() > const &fn);
 
+//A load split into stages:
+struct LoadStages {
+	std::string name; //shown in the startup timeline, and what other loads' 'after' lists refer to
+	std::function< void() > cpu; //(optional) runs on a worker thread -- no OpenGL!
+	std::function< void() > gl; //(optional) runs on the main thread once 'cpu' is done
+	std::vector< std::string > after; //names of loads (with the same or an earlier tag) that must finish first
+};
+
+//Add a staged load:
+// (only call *before* "call_load_functions()")
+void add_load_stages(LoadTag tag, LoadStages const &stages);
+
 //Call all loading functions:
 // (loading functions may throw exceptions if they fail.)
 // (only call *once*)
+// (logs a timeline of the loads, with LOG_INFO, once done)
 void call_load_functions();
 
 
@@ -58,6 +89,26 @@ struct Load {
 		});
 	}
 
+	//Constructing a Load< T > with a name loads it on a worker thread:
+	// (gl_fn, if given, is then called on the main thread to finish it off)
+	Load(LoadTag tag, std::string const &name, const std::function< T const *() > &load_fn, const std::function< void(T const &) > &gl_fn = nullptr, std::vector< std::string > const &after = {}) : value(nullptr) {
+		LoadStages stages;
+		stages.name = name;
+		stages.cpu = [this,load_fn](){
+			this->value = load_fn();
+			if (!(this->value)) {
+				throw std::runtime_error("Loading failed.");
+			}
+		};
+		if (gl_fn) {
+			stages.gl = [this,gl_fn](){
+				gl_fn(*(this->value));
+			};
+		}
+		stages.after = after;
+		add_load_stages(tag, stages);
+	}
+
 	//Make a "Load< T >" behave like a "T const *":
 	explicit operator bool() { return value != nullptr; }
 	operator T const *() { return value; }
@@ -0,0 +1,196 @@
+#include "Log.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// single-producer (the owning thread), single-consumer (whoever holds Logger::mutex) ring:
+struct Ring {
+    static constexpr uint32_t Capacity = 256; // (power of two)
+    alignas(64) std::atomic<uint32_t> head { 0 }; // next record to write; only the producer stores
+    alignas(64) std::atomic<uint32_t> tail { 0 }; // next record to read; only the consumer stores
+    std::atomic<bool> retired { false }; // owning thread has exited
+    std::array<Log::Record, Capacity> records;
+};
+
+struct Logger {
+    Logger()
+        : start(Clock::now())
+    {
+        thread = std::thread([this]() { run(); });
+    }
+    ~Logger()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_one();
+        thread.join();
+        drain();
+        if (output != stderr) {
+            std::fclose(output);
+        }
+    }
+
+    Clock::time_point start;
+    std::atomic<uint64_t> dropped { 0 };
+
+    // held only briefly (adding a ring, or taking records out of them), never across I/O,
+    //  so a thread logging for the first time doesn't wait on a write:
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Ring>> rings;
+    bool quit = false;
+
+    // held by drain from taking records out until they are written, so batches come out in order:
+    std::mutex write_mutex;
+    std::vector<Log::Record> batch; // (scratch space for drain)
+    FILE* output = stderr;
+
+    std::condition_variable wake;
+    std::thread thread;
+
+    Ring* add_ring()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        rings.emplace_back(std::make_unique<Ring>());
+        return rings.back().get();
+    }
+
+    // write out everything in the rings, oldest first:
+    void drain()
+    {
+        std::unique_lock<std::mutex> write_lock(write_mutex);
+        std::unique_lock<std::mutex> lock(mutex);
+        batch.clear();
+        for (auto& ring : rings) {
+            bool retired = ring->retired.load(std::memory_order_acquire);
+            uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+            uint32_t head = ring->head.load(std::memory_order_acquire);
+            for (; tail != head; ++tail) {
+                batch.emplace_back(ring->records[tail & (Ring::Capacity - 1)]);
+            }
+            ring->tail.store(tail, std::memory_order_release);
+            if (retired) {
+                ring.reset(); // (its thread is gone, so nothing more can arrive)
+            }
+        }
+        rings.erase(std::remove(rings.begin(), rings.end(), nullptr), rings.end());
+        lock.unlock();
+
+        // rings are per-thread, so merge them back into time order:
+        std::stable_sort(batch.begin(), batch.end(), [](Log::Record const& a, Log::Record const& b) {
+            return a.time_us < b.time_us;
+        });
+        static char const* names[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+        for (Log::Record const& r : batch) {
+            std::fprintf(output, "[%9.3f] %-5s %.*s%s\n", r.time_us * 1e-6, names[r.level], int(r.length), r.text, r.truncated ? "..." : "");
+        }
+        if (!batch.empty()) {
+            std::fflush(output);
+        }
+    }
+
+    void run()
+    {
+        while (true) {
+            drain();
+            std::unique_lock<std::mutex> lock(mutex);
+            if (quit) {
+                break;
+            }
+            wake.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+};
+
+Logger& logger()
+{
+    static Logger logger;
+    return logger;
+}
+
+// each thread's ring is created on its first message and retired when the thread exits:
+struct ThreadRing {
+    Ring* ring = nullptr;
+    ~ThreadRing()
+    {
+        if (ring) {
+            ring->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+thread_local ThreadRing thread_ring;
+
+} // namespace
+
+namespace Log {
+
+void set_output(std::string const& filename)
+{
+    Logger& l = logger();
+    FILE* file = stderr;
+    if (!filename.empty()) {
+        file = std::fopen(filename.c_str(), "a");
+        if (!file) {
+            throw std::runtime_error("Failed to open log file '" + filename + "'.");
+        }
+    }
+    l.drain(); // (so earlier messages go to the old output)
+    std::unique_lock<std::mutex> lock(l.write_mutex);
+    if (l.output != stderr) {
+        std::fclose(l.output);
+    }
+    l.output = file;
+}
+
+void flush()
+{
+    logger().drain();
+}
+
+uint64_t dropped()
+{
+    return logger().dropped.load(std::memory_order_relaxed);
+}
+
+Line::Line(Level level)
+    : buffer(record.text, record.text + Record::TextSize)
+    , out(&buffer)
+{
+    record.level = level;
+    record.time_us = uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - logger().start).count());
+}
+
+Line::~Line()
+{
+    record.length = uint16_t(buffer.written());
+    record.truncated = out.bad();
+
+    Logger& l = logger();
+    if (!thread_ring.ring) {
+        thread_ring.ring = l.add_ring();
+    }
+    Ring& ring = *thread_ring.ring;
+    uint32_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= Ring::Capacity) {
+        l.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring.records[head & (Ring::Capacity - 1)] = record;
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+} // namespace Log
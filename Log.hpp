@@ -0,0 +1,90 @@
+#pragma once
+
+/*
+ * Log -- asynchronous logging with severity levels.
+ *
+ * Usage:
+ *   LOG_INFO("Loaded " << count << " tiles.");
+ *   LOG_WARN("Bits index: " << idx << " out of bounds");
+ *
+ * Messages are formatted on the calling thread straight into a fixed-size record
+ * (no allocation; long messages are truncated) which goes into a ring buffer owned by
+ * that thread. Pushing is lock-free: each ring has exactly one producer (its thread)
+ * and one consumer (the flush thread), which writes the records out to stderr or a file.
+ *
+ * If a ring is full the message is dropped and counted rather than blocking the caller;
+ * see Log::dropped().
+ *
+ * Messages below LOG_LEVEL (compile-time; e.g. -DLOG_LEVEL=0 to include Debug) are
+ * compiled out entirely, arguments and all.
+ */
+
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL 1 // Info
+#endif
+
+namespace Log {
+
+enum Level : uint8_t {
+    Debug = 0,
+    Info = 1,
+    Warn = 2,
+    Error = 3,
+};
+
+// one message as stored in a ring buffer:
+struct Record {
+    static constexpr uint32_t TextSize = 232;
+    uint64_t time_us; // microseconds since the logger started
+    Level level;
+    uint8_t truncated;
+    uint16_t length;
+    char text[TextSize];
+};
+
+// write to 'filename' (appending) instead of stderr; "" goes back to stderr:
+//  (throws on failure)
+void set_output(std::string const& filename);
+
+// block until every message logged so far (by any thread) has been written:
+void flush();
+
+// number of messages dropped because a ring buffer was full:
+uint64_t dropped();
+
+// Line -- formats one message into a Record and pushes it when destroyed:
+struct Line {
+    Line(Level level);
+    ~Line();
+    std::ostream& stream() { return out; }
+
+private:
+    struct Buffer : std::streambuf {
+        Buffer(char* begin, char* end) { setp(begin, end); }
+        int_type overflow(int_type ch) override { return traits_type::eof(); } // (full: truncate)
+        std::streamsize written() const { return pptr() - pbase(); }
+    };
+    Record record;
+    Buffer buffer;
+    std::ostream out;
+};
+
+} // namespace Log
+
+#define LOG_AT(LEVEL, X)                             \
+    do {                                             \
+        if constexpr (Log::LEVEL >= LOG_LEVEL) {     \
+            Log::Line log_line_(Log::LEVEL);         \
+            log_line_.stream() << X;                 \
+        }                                            \
+    } while (0)
+
+#define LOG_DEBUG(X) LOG_AT(Debug, X)
+#define LOG_INFO(X) LOG_AT(Info, X)
+#define LOG_WARN(X) LOG_AT(Warn, X)
+#define LOG_ERROR(X) LOG_AT(Error, X)
@@ -99,10 +99,42 @@ if (maek.OS === 'windows') {
 // cppFile: name of c++ file to compile
 // objFileBase (optional): base name object file to produce (if not supplied, set to options.objDir + '/' + cppFile without the extension)
 //returns objFile: objFileBase + a platform-dependant suffix ('.o' or '.obj')
+const game_obj = maek.CPP('Game.cpp');
+const bullets_obj = maek.CPP('Bullets.cpp');
+const chunk_file_obj = maek.CPP('ChunkFile.cpp');
+const replay_obj = maek.CPP('Replay.cpp');
+const log_obj = maek.CPP('Log.cpp');
+const rewind_obj = maek.CPP('Rewind.cpp');
+const bot_obj = maek.CPP('Bot.cpp');
+const sprites_obj = maek.CPP('Sprites.cpp');
+const thread_pool_obj = maek.CPP('ThreadPool.cpp');
+const quantizer_obj = maek.CPP('Quantizer.cpp');
+const resampler_obj = maek.CPP('Resampler.cpp');
+const sprite_cache_obj = maek.CPP('SpriteCache.cpp');
+const sprite_list_obj = maek.CPP('SpriteList.cpp');
+const tilemap_obj = maek.CPP('Tilemap.cpp');
+
 const game_objs = [
 	maek.CPP('PlayMode.cpp'),
+	game_obj,
+	bullets_obj,
+	replay_obj,
+	chunk_file_obj,
+	rewind_obj,
+	log_obj,
+	bot_obj,
 	maek.CPP('PPU466.cpp'),
+	sprites_obj,
+	thread_pool_obj,
 	maek.CPP('main.cpp'),
+	quantizer_obj,
+	resampler_obj,
+	maek.CPP('TileAtlas.cpp'),
+	sprite_list_obj,
+	sprite_cache_obj,
+	maek.CPP('FileWatcher.cpp'),
+	maek.CPP('HotReload.cpp'),
+	tilemap_obj,
 	maek.CPP('load_save_png.cpp'),
 	maek.CPP('Load.cpp'),
 	maek.CPP('data_path.cpp'),
@@ -115,10 +147,104 @@ const game_objs = [
 // objFiles: array of objects to link
 // exeFileBase: name of executable file to produce
 //returns exeFile: exeFileBase + a platform-dependant suffix (e.g., '.exe' on windows)
-const game_exe = maek.LINK(game_objs, 'dist/game');
+//(the logger runs a background thread)
+const THREAD_LIBS = (maek.OS === 'windows' ? [] : [`-lpthread`]);
+
+const game_exe = maek.LINK(game_objs, 'dist/game', { LINKLibs: [...maek.options.LINKLibs, ...THREAD_LIBS] });
+
+//the headless tools only need the simulation (no SDL, GL, or libpng):
+
+const kinetic_obj = maek.CPP('Kinetic.cpp');
+
+const headless_objs = [
+	game_obj,
+	bullets_obj,
+	replay_obj,
+	chunk_file_obj,
+	log_obj,
+	thread_pool_obj,
+	bot_obj,
+	kinetic_obj,
+	maek.CPP('headless.cpp')
+];
+
+const headless_exe = maek.LINK(headless_objs, 'dist/headless', { LINKLibs: THREAD_LIBS });
+
+const bench_objs = [
+	game_obj,
+	bullets_obj,
+	rewind_obj,
+	log_obj,
+	kinetic_obj,
+	chunk_file_obj,
+	quantizer_obj,
+	resampler_obj,
+	tilemap_obj,
+	maek.CPP('bench.cpp')
+];
+
+const bench_exe = maek.LINK(bench_objs, 'dist/bench', { LINKLibs: THREAD_LIBS });
+
+const netplay_objs = [
+	game_obj,
+	bullets_obj,
+	log_obj,
+	maek.CPP('Rollback.cpp'),
+	maek.CPP('Transport.cpp'),
+	maek.CPP('netplay.cpp')
+];
+
+const netplay_exe = maek.LINK(netplay_objs, 'dist/netplay', { LINKLibs: THREAD_LIBS });
+
+const sweep_objs = [
+	game_obj,
+	bullets_obj,
+	log_obj,
+	thread_pool_obj,
+	bot_obj,
+	maek.CPP('sweep.cpp')
+];
+
+const sweep_exe = maek.LINK(sweep_objs, 'dist/sweep', { LINKLibs: THREAD_LIBS });
+
+//assets are baked ahead of time, so the game doesn't decode or convert PNGs at startup:
+const PNG_LIBS = (maek.OS === 'windows'
+	? [`/LIBPATH:${NEST_LIBS}/libpng/lib`, `libpng.lib`, `/LIBPATH:${NEST_LIBS}/zlib/lib`, `zlib.lib`]
+	: [`-L${NEST_LIBS}/libpng/lib`, `-lpng`, `-L${NEST_LIBS}/zlib/lib`, `-lz`]);
+
+const pack_sprites_objs = [
+	sprites_obj,
+	chunk_file_obj,
+	log_obj,
+	sprite_list_obj,
+	sprite_cache_obj,
+	quantizer_obj,
+	resampler_obj,
+	maek.CPP('load_save_png.cpp'),
+	maek.CPP('pack-sprites.cpp')
+];
+
+const pack_sprites_exe = maek.LINK(pack_sprites_objs, 'dist/pack-sprites', { LINKLibs: [...PNG_LIBS, ...THREAD_LIBS] });
+
+const sprite_pngs = ['assets/siphon.png', 'assets/bolt.png', 'assets/target.png'];
+maek.RULE(['dist/redirekt.sprites'], [pack_sprites_exe, 'assets/sprites.txt', ...sprite_pngs], [
+	[pack_sprites_exe, '--cache', 'objs/sprite-cache', '--prune', 'assets/sprites.txt', 'dist/redirekt.sprites']
+]);
+
+const pack_tilemap_objs = [
+	tilemap_obj,
+	chunk_file_obj,
+	maek.CPP('pack-tilemap.cpp')
+];
+
+const pack_tilemap_exe = maek.LINK(pack_tilemap_objs, 'dist/pack-tilemap', { LINKLibs: [] });
+
+maek.RULE(['dist/redirekt.tilemap'], [pack_tilemap_exe, 'assets/level.txt'], [
+	[pack_tilemap_exe, 'assets/level.txt', 'dist/redirekt.tilemap']
+]);
 
-//set the default target to the game (and copy the readme files):
-maek.TARGETS = [game_exe, ...copies];
+//set the default target to the game and its assets (and copy the readme files):
+maek.TARGETS = [game_exe, 'dist/redirekt.sprites', 'dist/redirekt.tilemap', headless_exe, bench_exe, netplay_exe, sweep_exe, ...copies];
 
 //the 'RULE(targets, prerequisites[, recipe])' rule defines a Makefile-style task
 // targets: array of targets the task produces (can include both files and ':abstract targets')
@@ -126,7 +252,7 @@ maek.TARGETS = [game_exe, ...copies];
 // recipe (optional): array of commands to run (where each command is an array [exe, arg1, arg0, ...])
 //returns targets: the targets the rule produces
 maek.RULE([':run'], [game_exe], [
-	[game_exe, '--some-command-line-option']
+	[game_exe]
 ]);
 
 //Note that tasks that produce ':abstract targets' are never cached.
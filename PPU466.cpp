@@ -63,6 +63,12 @@ struct PPUDataStream {
 
     // texture object that will store palette table:
     GLuint palette_tex = 0;
+
+    // what tile_tex and palette_tex hold right now, so draw() only uploads entries that changed:
+    //  (mutable, since Load<> hands out a const data stream)
+    mutable std::array<PPU466::Tile, 16 * 16> uploaded_tiles;
+    mutable std::array<PPU466::Palette, 8> uploaded_palettes;
+    mutable bool uploaded = false; // (false until the first upload, when everything goes)
 };
 
 Load<PPUDataStream> data_stream(LoadTagDefault);
@@ -207,35 +213,56 @@ void PPU466::draw(glm::uvec2 const& drawable_size) const
     //-------------------------------------------------
     // Upload at to GPU using PPUDataStream:
 
-    { // upload palette texture:
+    { // upload palette texture (if any palette changed -- it's only 128 bytes):
         static_assert(sizeof(palette_table) == 4 * 4 * decltype(palette_table)().size(), "palette table is packed");
-        glBindTexture(GL_TEXTURE_2D, data_stream->palette_tex);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 4, GLsizei(palette_table.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE, palette_table.data());
-        glBindTexture(GL_TEXTURE_2D, 0);
+        if (!data_stream->uploaded || data_stream->uploaded_palettes != palette_table) {
+            glBindTexture(GL_TEXTURE_2D, data_stream->palette_tex);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 4, GLsizei(palette_table.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE, palette_table.data());
+            glBindTexture(GL_TEXTURE_2D, 0);
+            data_stream->uploaded_palettes = palette_table;
+        }
     }
 
-    { // build + upload tile table texture:
-        // interpret tiles and build a 128 x 128 index texture:
-        static std::array<uint8_t, 128 * 128> data;
-        for (uint32_t i = 0; i < tile_table.size(); ++i) {
-            Tile const& tile = tile_table[i];
-
-            // location of tile in the texture:
-            uint32_t ox = (i % 16) * 8;
-            uint32_t oy = (i / 16) * 8;
-
-            // copy tile indices into texture:
+    { // build + upload tile table texture (just the tiles that changed since the last upload):
+        // interpret a tile as 8x8 indices, at 'stride' bytes per row:
+        auto expand = [](Tile const& tile, uint8_t* out, uint32_t stride) {
             for (uint32_t y = 0; y < 8; ++y) {
                 for (uint32_t x = 0; x < 8; ++x) {
-                    data[ox + x + 128 * (oy + y)] = ((tile.bit0[y] >> x) & 1)
+                    out[x + stride * y] = ((tile.bit0[y] >> x) & 1)
                         | ((tile.bit1[y] >> x) & 1) << 1;
                 }
             }
-        }
+        };
 
         glBindTexture(GL_TEXTURE_2D, data_stream->tile_tex);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, 128, 128, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, data.data());
+        if (!data_stream->uploaded) {
+            // build the whole 128 x 128 index texture:
+            //  (not static, so that several PPUs can draw from different threads)
+            std::array<uint8_t, 128 * 128> data;
+            for (uint32_t i = 0; i < tile_table.size(); ++i) {
+                // location of tile in the texture:
+                uint32_t ox = (i % 16) * 8;
+                uint32_t oy = (i / 16) * 8;
+                expand(tile_table[i], &data[ox + 128 * oy], 128);
+            }
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, 128, 128, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, data.data());
+            data_stream->uploaded_tiles = tile_table;
+        } else {
+            // (usually none: tiles only change when sprites are loaded or hot-reloaded)
+            for (uint32_t i = 0; i < tile_table.size(); ++i) {
+                Tile const& tile = tile_table[i];
+                Tile& uploaded = data_stream->uploaded_tiles[i];
+                if (tile.bit0 == uploaded.bit0 && tile.bit1 == uploaded.bit1) {
+                    continue;
+                }
+                std::array<uint8_t, 8 * 8> data;
+                expand(tile, data.data(), 8);
+                glTexSubImage2D(GL_TEXTURE_2D, 0, GLint((i % 16) * 8), GLint((i / 16) * 8), 8, 8, GL_RED_INTEGER, GL_UNSIGNED_BYTE, data.data());
+                uploaded = tile;
+            }
+        }
         glBindTexture(GL_TEXTURE_2D, 0);
+        data_stream->uploaded = true;
     }
 
     { // upload vertex data:
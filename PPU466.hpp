@@ -7,10 +7,10 @@
 
 #include <array>
 #include <glm/glm.hpp>
-#include <iostream>
 #include <vector>
 #include <algorithm>
 
+#include "Log.hpp"
 #include "load_save_png.hpp"
 
 struct PPU466 {
@@ -161,7 +161,7 @@ struct SpriteData {
 
         // copy over the bits
         auto generateBitmap = [&](const std::vector<glm::u8vec4>& dataTmp) {
-            auto get_col_idx = [colour_bank](const glm::u8vec4& col) {
+            auto get_col_idx = [&colour_bank](const glm::u8vec4& col) {
                 for (size_t i = 0; i < colour_bank.size(); i++) {
                     if (col == colour_bank[i]) {
                         return i;
@@ -210,8 +210,7 @@ struct SpriteData {
     struct PPU466::Tile GetBits(int idx = 0) const
     {
         if (idx >= (int)bits.size()) {
-            std::cout << "[WARN]"
-                      << "Bits index: " << idx << " out of bounds" << std::endl;
+            LOG_WARN("Bits index: " << idx << " out of bounds");
             idx = bits.size() - 1; // set to max
         }
         return bits[idx];
@@ -6,17 +6,36 @@
 // for glm::value_ptr() :
 #include <glm/gtc/type_ptr.hpp>
 
-// load_save_png
-#include "load_save_png.hpp"
+#include "Load.hpp"
+#include "Log.hpp"
+#include "Sprites.hpp"
+#include "TileAtlas.hpp"
+#include "Tilemap.hpp"
+#include "data_path.hpp"
 
 #include <algorithm> // std::clamp
+#include <chrono>
 #include <random>
-
-PlayMode::PlayMode()
+#include <stdexcept>
+#include <string>
+
+// (on a worker thread, see Load.hpp; the tables are copied into the PPU when a PlayMode is made)
+Load<Sprites> sprites(LoadTagDefault, "sprites", []() -> Sprites const* {
+    auto before = std::chrono::high_resolution_clock::now();
+    Sprites const* ret = new Sprites(data_path("redirekt.sprites"));
+    double us = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - before).count();
+    LOG_INFO("Loaded " << ret->sprites.size() << " sprites in " << us << " us.");
+    return ret;
+});
+
+// (baked by dist/pack-tilemap from assets/level.txt; decoded into the PPU background when a PlayMode is made)
+Load<Tilemap> level(LoadTagDefault, "level", []() -> Tilemap const* {
+    return new Tilemap(data_path("redirekt.tilemap"));
+});
+
+PlayMode::PlayMode(uint32_t seed, GameConfig const& config)
+    : game(seed, 1, config)
 {
-
-    int globalSpriteIndex = 0; // increases with every new sprite
-
     // meta stuff
     {
         // attribute 0 is undrawn
@@ -28,149 +47,103 @@ PlayMode::PlayMode()
         };
     }
 
-    // main character
+    // background (pointed at its tiles by use_sprites, below)
     {
-        // load png
-        glm::uvec2 size;
-        std::vector<glm::u8vec4> data;
-        load_png("assets/siphon.png", &size, &data);
-        std::vector<glm::u8vec4> colour_bank = {
-            glm::u8vec4(0, 0, 0, 0),
-            glm::u8vec4(128, 128, 128, 255),
-            glm::u8vec4(255, 0, 0, 255),
-            glm::u8vec4(0, 0, 0, 0),
+        ppu.palette_table[BACKGROUND_COLOUR] = {
+            glm::u8vec4(0x11, 0x11, 0x11, 0xff),
+            glm::u8vec4(0x11, 0x11, 0x11, 0xff),
+            glm::u8vec4(0x11, 0x11, 0x99, 0xff),
+            glm::u8vec4(0xff, 0xff, 0x11, 0xff),
         };
-        // convert_to_n_colours(4, size, &(data[0]), colour_bank);
-        convert_to_new_size_with_bank(glm::uvec2(8, 8), size, data, colour_bank);
-
-        siphon_sd = SpriteData(data, colour_bank, true);
-
-        // initialize siphon (player) data
-        siphon.spriteID = globalSpriteIndex;
-        siphon.speed = 80.f;
-        globalSpriteIndex++;
-        siphon.pos.x = PPU466::ScreenWidth / 2;
-        siphon.pos.y = PPU466::ScreenHeight / 2;
-        siphon.sprite.index = SIPHON_SPRITE_IDX;
-        siphon.sprite.attributes = SIPHON_COLOUR;
-        ppu.tile_table[siphon.sprite.index] = siphon_sd.GetBits();
-        ppu.palette_table[siphon.sprite.attributes] = siphon_sd.colours;
-    }
 
-    // projectiles
-    {
-        projectiles.reserve(numProjectiles);
-        // load png
-        glm::uvec2 size;
-        std::vector<glm::u8vec4> data;
-        load_png("assets/bolt.png", &size, &data);
-        std::vector<glm::u8vec4> colour_bank = {
-            glm::u8vec4(0, 0, 0, 0),
-            glm::u8vec4(255, 255, 0, 255),
-            glm::u8vec4(0, 0, 0, 0),
-            glm::u8vec4(0, 0, 0, 0),
-        };
-        convert_to_new_size_with_bank(glm::uvec2(8, 8), size, data, colour_bank);
-
-        SpriteData projectile_sd = SpriteData(data, colour_bank, true);
-        // colours used for the misc other sprites:
-        ppu.palette_table[PROJECTILE_COLOUR] = projectile_sd.colours;
-        ppu.tile_table[PROJECTILE_SPRITE_IDX_0] = projectile_sd.GetBits(0);
-        ppu.tile_table[PROJECTILE_SPRITE_IDX_1] = projectile_sd.GetBits(1); // rotated 90 deg (horizontal)
-
-        for (int i = 0; i < numProjectiles; i++) {
-            MovingObject newProj;
-            newProj.speed = 50.f;
-            newProj.spriteID = globalSpriteIndex;
-            globalSpriteIndex++;
-            newProj.sprite.index = PROJECTILE_SPRITE_IDX_0;
-            newProj.sprite.attributes = PROJECTILE_COLOUR;
-            newProj.randomInit();
-            projectiles.push_back(newProj);
+        if (level->legend.empty()) {
+            throw std::runtime_error("The level has no legend of sprites (it predates them; rebuild it with dist/pack-tilemap).");
+        }
+        // (anything the level doesn't cover shows the first legend tile)
+        level_background.assign(ppu.background.size(), uint16_t(BACKGROUND_COLOUR << 8));
+        if (level->width <= PPU466::BackgroundWidth && level->height <= PPU466::BackgroundHeight) {
+            level->decode(level_background.data(), PPU466::BackgroundWidth);
+        } else {
+            // a world bigger than the background: decode it all, then show its bottom left corner
+            std::vector<uint16_t> world(size_t(level->width) * level->height);
+            level->decode(world.data(), level->width);
+            for (uint32_t y = 0; y < std::min(level->height, uint32_t(PPU466::BackgroundHeight)); ++y) {
+                std::copy_n(&world[size_t(y) * level->width], std::min(level->width, uint32_t(PPU466::BackgroundWidth)),
+                    &level_background[size_t(y) * PPU466::BackgroundWidth]);
+            }
+        }
+        for (uint16_t entry : level_background) {
+            if ((entry & 0xff) >= level->legend.size()) {
+                throw std::runtime_error("The level uses tile " + std::to_string(entry & 0xff) + ", past the end of its legend.");
+            }
         }
     }
 
-    // targets
-    {
-        targets.reserve(numTargets);
-        // load png
-        glm::uvec2 size;
-        std::vector<glm::u8vec4> data;
-        load_png("assets/target.png", &size, &data);
-        std::vector<glm::u8vec4> colour_bank = {
-            glm::u8vec4(0, 0, 0, 0),
-            glm::u8vec4(255, 0, 0, 255),
-            glm::u8vec4(255, 255, 255, 255),
-            glm::u8vec4(0, 0, 0, 0),
-        };
-        convert_to_new_size_with_bank(glm::uvec2(8, 8), size, data, colour_bank);
-
-        SpriteData target_sd = SpriteData(data, colour_bank, false);
-        // colours used for the misc other sprites:
-        ppu.palette_table[TARGET_COLOUR] = target_sd.colours;
-        ppu.tile_table[TARGET_SPRITE_IDX] = target_sd.GetBits();
-
-        for (int i = 0; i < numTargets; i++) {
-            MovingObject newTarget;
-            newTarget.speed = 30.f;
-            newTarget.spriteID = globalSpriteIndex;
-            globalSpriteIndex++;
-            newTarget.sprite.index = TARGET_SPRITE_IDX;
-            newTarget.sprite.attributes = TARGET_COLOUR;
-            newTarget.randomInit();
-            targets.push_back(newTarget);
-        }
+    // sprites (baked ahead of time by dist/pack-sprites, see Sprites.hpp):
+    use_sprites(*sprites);
+}
+
+void PlayMode::use_sprites(Sprites const& from)
+{
+    // (everything is looked up first, so a missing sprite changes nothing)
+    Sprites::Sprite const& siphon = from.lookup("siphon");
+    Sprites::Sprite const& bolt = from.lookup("bolt");
+    Sprites::Sprite const& target = from.lookup("target");
+    Sprites::Sprite const& super_target = from.lookup("super_target");
+    std::vector<Sprites::Sprite const*> legend_sprites;
+    for (Tilemap::Tile const& tile : level->legend) {
+        legend_sprites.emplace_back(&from.lookup(tile.sprite));
     }
 
-    // super targets
-    {
-        superTargets.reserve(numSuperTargets);
-        // load png
-        glm::uvec2 size;
-        std::vector<glm::u8vec4> data;
-        load_png("assets/target.png", &size, &data);
-        std::vector<glm::u8vec4> colour_bank = {
-            glm::u8vec4(0, 0, 0, 0),
-            glm::u8vec4(255, 0, 255, 255),
-            glm::u8vec4(255, 255, 255, 255),
-            glm::u8vec4(0, 0, 0, 0),
-        };
-        convert_to_new_size_with_bank(glm::uvec2(8, 8), size, data, colour_bank);
-
-        SpriteData target_sd = SpriteData(data, colour_bank, false);
-        // colours used for the misc other sprites:
-        ppu.palette_table[SUPER_TARGET_COLOUR] = target_sd.colours;
-        ppu.tile_table[TARGET_SPRITE_IDX] = target_sd.GetBits();
-
-        for (int i = 0; i < numSuperTargets; i++) {
-            MovingObject newTarget;
-            newTarget.speed = 20.f;
-            newTarget.spriteID = globalSpriteIndex;
-            globalSpriteIndex++;
-            newTarget.sprite.index = TARGET_SPRITE_IDX;
-            newTarget.sprite.attributes = SUPER_TARGET_COLOUR;
-            newTarget.randomInit();
-            newTarget.hide(3 + rand() % 3);
-            superTargets.push_back(newTarget);
-        }
+    // tiles are packed into the tile table by a TileAtlas, so every rotation gets a slot once up front
+    //  and tiles that come out identical share one (into locals, since the atlas throws once it is full):
+    TileAtlas atlas;
+    std::array<uint8_t, 4> new_siphon_tiles;
+    for (uint32_t r = 0; r < new_siphon_tiles.size(); ++r) {
+        new_siphon_tiles[r] = atlas.add(siphon.tile(from, r));
     }
 
-    // background
-    {
-        ppu.palette_table[BACKGROUND_COLOUR] = {
-            glm::u8vec4(0x11, 0x11, 0x11, 0xff),
-            glm::u8vec4(0x11, 0x11, 0x11, 0xff),
-            glm::u8vec4(0x11, 0x11, 0x99, 0xff),
-            glm::u8vec4(0xff, 0xff, 0x11, 0xff),
-        };
+    std::array<uint8_t, 2> new_bolt_tiles;
+    new_bolt_tiles[0] = atlas.add(bolt.tile(from, 0));
+    new_bolt_tiles[1] = atlas.add(bolt.tile(from, 1)); // rotated 90 deg (horizontal)
+
+    // (targets and super targets share a tile, and differ in palette)
+    const uint8_t new_target_tile = atlas.add(target.tile(from));
 
-        for (uint32_t y = 0; y < PPU466::BackgroundHeight; ++y) {
-            for (uint32_t x = 0; x < PPU466::BackgroundWidth; ++x) {
-                int bkg_idx = SIPHON_SPRITE_IDX;
-                ppu.background[x + PPU466::BackgroundWidth * y] = (BACKGROUND_COLOUR << 8) | bkg_idx;
+    // the level's tiles, by name (so it doesn't matter which slots they land in):
+    std::vector<std::array<uint8_t, 4>> new_legend_tiles(level->legend.size());
+    for (size_t i = 0; i < level->legend.size(); ++i) {
+        if (level->legend[i].rotation == Tilemap::FollowsAim) {
+            for (uint32_t aim = 0; aim < 4; ++aim) {
+                new_legend_tiles[i][aim] = atlas.add(legend_sprites[i]->tile(from, aim));
             }
+        } else {
+            new_legend_tiles[i].fill(atlas.add(legend_sprites[i]->tile(from, level->legend[i].rotation)));
         }
     }
+
+    // (nothing above touched the PPU; from here on nothing can throw)
+    ppu.palette_table[SIPHON_COLOUR] = from.palettes[siphon.palette];
+    ppu.palette_table[PROJECTILE_COLOUR] = from.palettes[bolt.palette];
+    ppu.palette_table[TARGET_COLOUR] = from.palettes[target.palette];
+    ppu.palette_table[SUPER_TARGET_COLOUR] = from.palettes[super_target.palette];
+    siphon_tiles = new_siphon_tiles;
+    bolt_tiles = new_bolt_tiles;
+    target_tile = new_target_tile;
+    legend_tiles = std::move(new_legend_tiles);
+
+    // (PPU466::draw only re-uploads the tiles and palettes that actually changed)
+    atlas.upload(&ppu.tile_table);
+    point_background();
+    LOG_INFO("Tile atlas: " << atlas.report() << ".");
+}
+
+void PlayMode::point_background()
+{
+    for (size_t i = 0; i < level_background.size(); ++i) {
+        const uint16_t entry = level_background[i];
+        ppu.background[i] = uint16_t((entry & 0xff00) | legend_tiles[entry & 0xff][background_rotation]);
+    }
 }
 
 PlayMode::~PlayMode()
@@ -179,7 +152,18 @@ PlayMode::~PlayMode()
 
 bool PlayMode::handle_event(SDL_Event const& evt, glm::uvec2 const& window_size)
 {
+    if (replay_from) {
+        return false; // input comes from the replay
+    }
     bool wasSuccess = false;
+    // (the bot can be rewound too; it drops its plan and makes a new one from wherever it ends up)
+    if ((evt.type == SDL_KEYDOWN || evt.type == SDL_KEYUP) && evt.key.keysym.sym == SDLK_BACKSPACE) {
+        rewinding = (evt.type == SDL_KEYDOWN);
+        return true;
+    }
+    if (bot) {
+        return false; // input comes from the bot
+    }
     if (evt.type == SDL_KEYDOWN) {
         for (auto& key_action : key_assignment) {
             if (evt.key.keysym.sym == key_action.second) {
@@ -199,121 +183,74 @@ bool PlayMode::handle_event(SDL_Event const& evt, glm::uvec2 const& window_size)
     return wasSuccess;
 }
 
-void PlayMode::PlayerUpdate(float dt)
-{
-    if (left.pressed) {
-        siphon.vel.x = -siphon.speed;
-    } else if (right.pressed) {
-        siphon.vel.x = +siphon.speed;
-    } else {
-        siphon.vel.x = 0;
-    }
-    if (down.pressed) {
-        siphon.vel.y = -siphon.speed;
-    } else if (up.pressed) {
-        siphon.vel.y = +siphon.speed;
-    } else {
-        siphon.vel.y = 0;
-    }
-    if (aim_left.pressed) {
-        siphon.aimDirection = 2;
-    }
-    if (aim_right.pressed) {
-        siphon.aimDirection = 0;
-    }
-    if (aim_down.pressed) {
-        siphon.aimDirection = 1;
-    }
-    if (aim_up.pressed) {
-        siphon.aimDirection = 3;
-    }
-    ppu.tile_table[siphon.sprite.index] = siphon_sd.GetBits(siphon.aimDirection);
-
-    siphon.pos += dt * siphon.vel;
-
-    siphon.pos.x = std::max(1.f, std::min(float(PPU466::ScreenWidth - 8), siphon.pos.x));
-    siphon.pos.y = std::max(1.f, std::min(float(PPU466::ScreenHeight - 8), siphon.pos.y));
-}
-
-void PlayMode::ProjectileUpdate(float dt)
+void PlayMode::update(float dt)
 {
-    for (MovingObject& p : projectiles) {
-        // change the sprite based on velocity (heading direction)
-        if (p.vel.y != 0) {
-            p.sprite.index = PROJECTILE_SPRITE_IDX_0;
-        } else {
-            p.sprite.index = PROJECTILE_SPRITE_IDX_1;
+    if (rewinding && !replay_from) {
+        // step back two ticks per frame, keeping the buttons that are held right now:
+        uint64_t tick = std::max(history.first_tick(), history.tick() - std::min<uint64_t>(2, history.tick()));
+        uint8_t held = game.get_buttons();
+        history.rewind(tick, &game);
+        game.set_buttons(held);
+        if (bot) {
+            bot->reset(); // (its plan was for a future that no longer happens)
         }
-        p.update(dt);
-        // check for collisions with player
-        if (siphon.collisionWith(p)) {
-            if (!p.collision) {
-                // only trigger this effect on the FIRST frame of collision
-                p.pos = siphon.pos;
-                p.vel = p.speed * p.directionMapping(siphon.aimDirection);
-            }
-            p.collision = true;
-        } else {
-            p.collision = false;
+        if (record_to) {
+            // (the recording follows the rewound timeline)
+            record_to->buttons.resize(tick);
+            record_to->elapsed.resize(tick);
         }
+        return;
     }
-}
 
-void PlayMode::TargetsUpdate(float dt)
-{
-    for (MovingObject& t : targets) {
-        t.update(dt);
-        for (MovingObject& p : projectiles) {
-            if (p.collisionWith(t)) {
-                t.hide(5); // hide this target for the next 5s
-                p.hide(2); // hide this projectile for the next 2s
-                score++;
-                std::cout << "[GOOD] Score: " << score << " ... Remaining: " << time_left << "s"<< std::endl;
-            }
+    if (replay_from) {
+        if (replay_tick >= replay_from->size()) {
+            Mode::set_current(nullptr); // replay is over
+            return;
         }
+        // replace both the input and the timestep with the recorded ones:
+        game.set_buttons(replay_from->buttons[replay_tick]);
+        dt = replay_from->elapsed[replay_tick];
+        replay_tick++;
+    } else if (bot) {
+        game.set_buttons(bot->next(game));
     }
-
-    for (MovingObject& t : superTargets) {
-        // make the edge respawn wait for a bit before respawning
-        t.update(dt);
-        for (MovingObject& p : projectiles) {
-            if (p.collisionWith(t)) {
-                t.hide(5);  // hide this target for the next 5s
-                p.hide(2);  // hide this projectile for the next 2s
-                score += 5; // super points
-                std::cout << "[SUPER] Score: " << score << " ... Remaining: " << time_left << "s" << std::endl;
-            }
-        }
+    if (record_to) {
+        record_to->record(game.get_buttons(), dt);
     }
-}
-
-void PlayMode::update(float dt)
-{
+    history.record(game, dt);
 
     // slowly rotates through [0,1):
     //  (will be used to set background color)
     background_fade += dt / 10.0f;
     background_fade -= std::floor(background_fade);
 
-    // tick down the game-over timer
-    time_left -= dt;
-
-    if (time_left > 0){
-        PlayerUpdate(dt);
-
-        ProjectileUpdate(dt);
+    game.update(dt);
 
-        TargetsUpdate(dt);
-    } else {
-        if (!end_msg){
-            std::cout << "Game over! Final score: " << score << std::endl;
-            end_msg = true;
+    // report what happened:
+    for (uint32_t i = 0; i < game.event_count; ++i) {
+        GameEvent const& event = game.events[i];
+        if (event.type == GameEvent::Hit) {
+            LOG_INFO((event.kind == Game::SuperTargetKind ? "[SUPER]" : "[GOOD]")
+                << " Score: " << event.score << " ... Remaining: " << event.time_left << "s");
+        } else if (event.type == GameEvent::GameOver) {
+            LOG_INFO("Game over! Final score: " << event.score);
         }
     }
 }
 
 void PlayMode::draw(glm::uvec2 const& drawable_size)
 {
+    // sprites saved since the last frame (converted already, on the hot reload's thread):
+    if (hot_reload) {
+        if (std::shared_ptr<Sprites const> fresh = hot_reload->take()) {
+            try {
+                use_sprites(*fresh);
+            } catch (std::exception const& e) {
+                LOG_ERROR("Hot reload: " << e.what());
+            }
+        }
+    }
+
     //--- set ppu state based on game state ---
 
     // background color will be some hsv-like fade:
@@ -324,32 +261,64 @@ void PlayMode::draw(glm::uvec2 const& drawable_size)
         0xff);
 
     // background scroll:
-    ppu.background_position += MovingObject::directionMapping(siphon.aimDirection);
+    ppu.background_position += MovingObject::directionMapping(game.siphons[0].aimDirection);
 
-    // player sprite:
-    siphon.sprite.x = siphon.pos.x;
-    siphon.sprite.y = siphon.pos.y;
-    ppu.sprites[siphon.spriteID] = siphon.sprite;
+    // background tiles turn with the player's aim (those the level's legend says should):
+    uint32_t aim = uint32_t(std::max(0, std::min(game.siphons[0].aimDirection, 3)));
+    if (aim != background_rotation) {
+        background_rotation = aim;
+        point_background();
+    }
 
-    // projectile sprites
-    for (const MovingObject& p : projectiles) {
-        p.updatePPU(ppu);
-        // if (i % 2)
-        //     ppu.sprites[i].attributes |= 0x80; //'behind' bit
+    // sprites are handed out to live objects in order, every frame:
+    uint32_t sprite_idx = 0;
+    auto draw_object = [&](Object const& obj, uint8_t index, uint8_t attributes) {
+        if (sprite_idx >= ppu.sprites.size()) {
+            return; // (out of sprites)
+        }
+        PPU466::Sprite& sprite = ppu.sprites[sprite_idx++];
+        sprite.x = uint8_t(obj.pos.x);
+        sprite.y = uint8_t(obj.pos.y);
+        sprite.index = index;
+        sprite.attributes = attributes;
+    };
+
+    // player sprites:
+    for (uint32_t p = 0; p < game.players; p++) {
+        uint32_t rotation = uint32_t(std::max(0, std::min(game.siphons[p].aimDirection, 3)));
+        draw_object(game.siphons[p], siphon_tiles[rotation], SIPHON_COLOUR);
     }
 
-    for (const MovingObject& t : targets) {
-        t.updatePPU(ppu);
+    // projectile sprites (the sprite is based on velocity, i.e. heading direction)
+    for (const MovingObject& p : game.projectiles) {
+        draw_object(p, bolt_tiles[p.vel.y != 0 ? 0 : 1], PROJECTILE_COLOUR);
         // if (i % 2)
         //     ppu.sprites[i].attributes |= 0x80; //'behind' bit
     }
 
-    for (const MovingObject& t : superTargets) {
-        t.updatePPU(ppu);
-        // if (i % 2)
-        //     ppu.sprites[i].attributes |= 0x80; //'behind' bit
+    for (const MovingObject& t : game.targets) {
+        draw_object(t, target_tile, TARGET_COLOUR);
+    }
+
+    for (const MovingObject& t : game.superTargets) {
+        draw_object(t, target_tile, SUPER_TARGET_COLOUR);
+    }
+
+    // pattern bullets get whatever sprites are left over:
+    for (uint32_t i = 0; i < game.bullets.count && sprite_idx < ppu.sprites.size(); i++) {
+        PPU466::Sprite& sprite = ppu.sprites[sprite_idx++];
+        sprite.x = uint8_t(game.bullets.x[i]);
+        sprite.y = uint8_t(game.bullets.y[i]);
+        bool vertical = std::abs(game.bullets.vy[i]) > std::abs(game.bullets.vx[i]);
+        sprite.index = bolt_tiles[vertical ? 0 : 1];
+        sprite.attributes = PROJECTILE_COLOUR;
+    }
+
+    // and any unused sprites are moved off-screen:
+    for (; sprite_idx < ppu.sprites.size(); sprite_idx++) {
+        ppu.sprites[sprite_idx].y = 240;
     }
 
     //--- actually draw ---
     ppu.draw(drawable_size);
-}
\ No newline at end of file
+}
@@ -1,9 +1,17 @@
+#include "Bot.hpp"
+#include "Game.hpp"
+#include "HotReload.hpp"
 #include "Mode.hpp"
 #include "PPU466.hpp"
+#include "Replay.hpp"
+#include "Rewind.hpp"
+#include "Sprites.hpp"
 
 #include <glm/glm.hpp>
 
+#include <array>
 #include <deque>
+#include <memory>
 #include <vector>
 
 // colour indexes
@@ -14,129 +22,8 @@
 #define SUPER_TARGET_COLOUR 6
 #define SIPHON_COLOUR 7
 
-// sprite indexes
-#define SIPHON_SPRITE_IDX 32
-#define PROJECTILE_SPRITE_IDX_0 33
-#define PROJECTILE_SPRITE_IDX_1 34
-#define TARGET_SPRITE_IDX 35
-
-struct Object {
-    int spriteID;
-    glm::vec2 pos, vel;
-    PPU466::Sprite sprite;
-    bool bIsEnabled = true;
-    float speed = 30.f;
-    float hiddenDuration = 0.f;
-
-    void updatePPU(PPU466& ppu) const
-    {
-        ppu.sprites[spriteID].x = pos[0];
-        ppu.sprites[spriteID].y = pos[1];
-        ppu.sprites[spriteID].index = sprite.index;
-        if (bIsEnabled) {
-            ppu.sprites[spriteID].attributes = sprite.attributes;
-        } else {
-            ppu.sprites[spriteID].attributes = CLEAR_COLOUR;
-        }
-    }
-
-    bool collisionWith(const Object& other) const
-    {
-        if (!(bIsEnabled && other.bIsEnabled)) {
-            return false;
-        }
-        const glm::vec2& otherPos = other.pos;
-        auto isPtIn = [this](const glm::vec2& pt) {
-            bool x_check = (pt.x > this->pos.x - 4 && pt.x < this->pos.x + 4);
-            bool y_check = (pt.y > this->pos.y - 4 && pt.y < this->pos.y + 4);
-            return x_check && y_check;
-        };
-        // check if the four corners (and the center) are within this sprite area
-        glm::vec2 topLeft = otherPos + glm::vec2(-4, 4);
-        glm::vec2 bottomLeft = otherPos + glm::vec2(-4, -4);
-        glm::vec2 topRight = otherPos + glm::vec2(4, 4);
-        glm::vec2 bottomRight = otherPos + glm::vec2(4, -4);
-        glm::vec2 center = otherPos; // if both sprites perfectly overlap then the corner float cmp's won't work reliably
-        return isPtIn(center) || isPtIn(topLeft) || isPtIn(bottomLeft) || isPtIn(topRight) || isPtIn(bottomRight);
-    }
-
-    bool atEdge() const
-    {
-        return (pos.x < 0 || pos.y < 0 || pos.x > PPU466::ScreenWidth || pos.y > PPU466::ScreenHeight);
-    }
-
-    void update(float dt)
-    {
-        pos += dt * vel;
-        hiddenDuration -= dt;
-        if (hiddenDuration > 0) {
-            pos = glm::vec2(-1, -1); // trigger a reinit after unhidden
-            bIsEnabled = false;
-        } else {
-            bIsEnabled = true;
-        }
-    }
-
-    void hide(float duration)
-    {
-        hiddenDuration = duration;
-    }
-};
-
-struct Siphon : Object {
-    int aimDirection = 0;
-};
-
-struct MovingObject : Object {
-    int wall;
-    bool collision = false;
-
-    static glm::vec2 directionMapping(int direction)
-    {
-        if (direction == 0) { // right
-            return glm::vec2(1, 0);
-        } else if (direction == 1) { // bottom
-            return glm::vec2(0, -1);
-        } else if (direction == 2) { // left
-            return glm::vec2(-1, 0);
-        }
-        return glm::vec2(0, 1); // up
-    }
-
-    void update(float dt)
-    {
-        Object::update(dt);
-        // reinitialize the location once they reach the edge
-        if (bIsEnabled && atEdge()) {
-            randomInit();
-        }
-    }
-
-    void randomInit()
-    {
-        wall = rand() % 4;
-        if (wall == 0) { // right
-            pos.x = PPU466::ScreenWidth - 8;
-            pos.y = rand() % PPU466::ScreenHeight - 8;
-            vel = -speed * directionMapping(0);
-        } else if (wall == 1) { // bottom
-            pos.y = 8;
-            pos.x = rand() % PPU466::ScreenHeight - 8;
-            vel = -speed * directionMapping(1);
-        } else if (wall == 2) { // left
-            pos.x = 8;
-            pos.y = rand() % PPU466::ScreenHeight - 8;
-            vel = -speed * directionMapping(2);
-        } else { // top
-            pos.x = rand() % PPU466::ScreenWidth - 8;
-            pos.y = PPU466::ScreenHeight - 8;
-            vel = -speed * directionMapping(3);
-        }
-    }
-};
-
 struct PlayMode : Mode {
-    PlayMode();
+    PlayMode(uint32_t seed, GameConfig const& config = GameConfig());
     virtual ~PlayMode();
 
     // functions called by main loop:
@@ -145,45 +32,57 @@ struct PlayMode : Mode {
     virtual void draw(glm::uvec2 const& drawable_size) override;
 
     //----- game state -----
-    int score = 0;
-    float time_left = 30.0f; // number of seconds you have to play the game
-    bool end_msg = false;
+    Game game;
 
-    Siphon siphon;
-    SpriteData siphon_sd;
-    void PlayerUpdate(float dt);
-
-    const int numProjectiles = 5;
-    std::vector<MovingObject> projectiles;
-    void ProjectileUpdate(float dt);
+    // input tracking:
+    std::vector<std::pair<Game::Button&, int>> key_assignment = {
+        { game.controls[0].aim_left, SDLK_LEFT },
+        { game.controls[0].aim_right, SDLK_RIGHT },
+        { game.controls[0].aim_up, SDLK_UP },
+        { game.controls[0].aim_down, SDLK_DOWN },
+        { game.controls[0].left, SDLK_a },
+        { game.controls[0].right, SDLK_d },
+        { game.controls[0].up, SDLK_w },
+        { game.controls[0].down, SDLK_s },
+    };
 
-    const int numTargets = 3;
-    std::vector<MovingObject> targets;
-    void TargetsUpdate(float dt);
+    //----- replays -----
+    Replay* record_to = nullptr; // if set, every tick's input is appended here
+    Replay const* replay_from = nullptr; // if set, input comes from here instead of handle_event
+    size_t replay_tick = 0; // next tick to read out of replay_from
 
-    const int numSuperTargets = 1;
-    std::vector<MovingObject> superTargets;
+    Bot* bot = nullptr; // if set, plays instead of handle_event (a replay takes precedence)
 
-    // input tracking:
-    struct Button {
-        uint8_t pressed = 0;
-    } left, right, down, up, aim_left, aim_right, aim_down, aim_up;
-
-    std::vector<std::pair<Button&, int>> key_assignment = {
-        { aim_left, SDLK_LEFT },
-        { aim_right, SDLK_RIGHT },
-        { aim_up, SDLK_UP },
-        { aim_down, SDLK_DOWN },
-        { left, SDLK_a },
-        { right, SDLK_d },
-        { up, SDLK_w },
-        { down, SDLK_s },
-    };
+    //----- rewinding -----
+    // hold backspace to run time backwards (through the last 'history.budget' bytes of history):
+    Rewind history = Rewind(4 << 20);
+    bool rewinding = false;
 
     // some weird background animation:
     float background_fade = 0.0f;
 
     //----- drawing handled by PPU466 -----
 
+    // sprites changed on disk while running, if set (picked up between frames, in draw()):
+    std::unique_ptr<SpriteHotReload> hot_reload;
+
+    // copy sprite tiles + palettes into the PPU (on construction, and again on every hot reload):
+    //  NOTE: throws (leaving the PPU as it was) if a sprite the game draws is missing
+    void use_sprites(Sprites const& sprites);
+
+    // tile table slots, handed out by a TileAtlas in use_sprites():
+    std::array<uint8_t, 4> siphon_tiles = {}; // (one per rotation, picked by aim direction)
+    std::array<uint8_t, 2> bolt_tiles = {}; // vertical, horizontal
+    uint8_t target_tile = 0; // (super targets use the same tile, with a different palette)
+
+    // the level as decoded, its entries holding legend indices rather than slots (see Tilemap.hpp):
+    std::vector<uint16_t> level_background;
+    // the slot for each legend index, per aim direction (the same slot four times, unless it turns with the aim):
+    std::vector<std::array<uint8_t, 4>> legend_tiles;
+    uint32_t background_rotation = 0; // (the aim direction the background is pointed for)
+
+    // write the PPU background from level_background + legend_tiles (on every hot reload or change of aim):
+    void point_background();
+
     PPU466 ppu;
 };
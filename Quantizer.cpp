@@ -0,0 +1,317 @@
+#include "Quantizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define QUANTIZER_SSE2 1
+#endif
+
+static inline int32_t distance2(glm::u8vec4 a, glm::u8vec4 b)
+{
+    int32_t dr = int32_t(a.r) - b.r, dg = int32_t(a.g) - b.g, db = int32_t(a.b) - b.b, da = int32_t(a.a) - b.a;
+    return dr * dr + dg * dg + db * db + da * da;
+}
+
+Quantizer::Quantizer(std::vector<glm::u8vec4> const& bank_, bool with_table)
+    : bank(bank_)
+{
+    if (bank.empty() || bank.size() > 255) {
+        throw std::runtime_error("Quantizer needs between 1 and 255 bank colours, not " + std::to_string(bank.size()) + ".");
+    }
+    if (!with_table) {
+        return;
+    }
+
+    // a cell spans 16 values per channel; every colour in it is within 'radius' of its centre, so if
+    // the closest bank colour to the centre beats the runner-up by more than 2 * radius, it is the
+    // closest everywhere in the cell (triangle inequality):
+    const float radius = std::sqrt(4.0f * 7.5f * 7.5f);
+    table.resize(16 * 16 * 16 * 16);
+    for (uint32_t cell = 0; cell < table.size(); ++cell) {
+        const glm::vec4 centre(
+            float((cell & 0xf) * 16) + 7.5f, float(((cell >> 4) & 0xf) * 16) + 7.5f,
+            float(((cell >> 8) & 0xf) * 16) + 7.5f, float(((cell >> 12) & 0xf) * 16) + 7.5f);
+        float best = 1e30f, second = 1e30f;
+        uint8_t best_index = 0;
+        for (uint32_t i = 0; i < bank.size(); ++i) {
+            float dist = glm::length(glm::vec4(bank[i]) - centre);
+            if (dist < best) {
+                second = best;
+                best = dist;
+                best_index = uint8_t(i);
+            } else if (dist < second) {
+                second = dist;
+            }
+        }
+        table[cell] = (second - best > 2.0f * radius + 1e-3f) ? best_index : Contested;
+    }
+}
+
+uint8_t Quantizer::search(glm::u8vec4 colour) const
+{
+    int32_t best = distance2(colour, bank[0]);
+    uint8_t best_index = 0;
+    for (uint32_t i = 1; i < bank.size(); ++i) {
+        int32_t dist = distance2(colour, bank[i]);
+        if (dist < best) {
+            best = dist;
+            best_index = uint8_t(i);
+        }
+    }
+    return best_index;
+}
+
+float Quantizer::coverage() const
+{
+    size_t single = 0;
+    for (uint8_t cell : table) {
+        single += (cell != Contested);
+    }
+    return table.empty() ? 0.0f : float(single) / float(table.size());
+}
+
+#if QUANTIZER_SSE2
+// squared distances from four pixels (16 bytes) to a colour (as four int16 channels, twice):
+static inline __m128i distance2_x4(__m128i pixels, __m128i colour)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(pixels, zero), colour); // pixels 0, 1
+    __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(pixels, zero), colour); // pixels 2, 3
+    lo = _mm_madd_epi16(lo, lo); // r*r + g*g, b*b + a*a of pixel 0, then of pixel 1
+    hi = _mm_madd_epi16(hi, hi);
+    __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+    return _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+}
+
+static inline __m128i select(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#endif
+
+void Quantizer::indices(glm::u8vec4 const* pixels, size_t count, uint8_t* out) const
+{
+    static_assert(sizeof(glm::u8vec4) == 4, "pixels are packed RGBA");
+    size_t i = 0;
+#if QUANTIZER_SSE2
+    // eight pixels at a time: keep the best distance and index of each in a lane, going through the bank
+    __m128i colours[255];
+    for (uint32_t b = 0; b < bank.size(); ++b) {
+        glm::u8vec4 c = bank[b];
+        colours[b] = _mm_setr_epi16(c.r, c.g, c.b, c.a, c.r, c.g, c.b, c.a);
+    }
+    const uint32_t bank_size = uint32_t(bank.size());
+    for (; i + 8 <= count; i += 8) {
+        __m128i p0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pixels + i));
+        __m128i p1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pixels + i + 4));
+        __m128i best0 = _mm_set1_epi32(0x7fffffff), best1 = best0;
+        __m128i index0 = _mm_setzero_si128(), index1 = index0;
+        for (uint32_t b = 0; b < bank_size; ++b) {
+            __m128i which = _mm_set1_epi32(int32_t(b));
+            __m128i d0 = distance2_x4(p0, colours[b]);
+            __m128i d1 = distance2_x4(p1, colours[b]);
+            __m128i closer0 = _mm_cmplt_epi32(d0, best0); // (strictly, so ties keep the earlier entry)
+            __m128i closer1 = _mm_cmplt_epi32(d1, best1);
+            best0 = select(closer0, d0, best0);
+            best1 = select(closer1, d1, best1);
+            index0 = select(closer0, which, index0);
+            index1 = select(closer1, which, index1);
+        }
+        // (indices are < 256, so they pack down to bytes without saturating)
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(index0, index1), _mm_setzero_si128());
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = index(pixels[i]);
+    }
+}
+
+void Quantizer::quantize(glm::u8vec4* pixels, size_t count) const
+{
+    uint8_t chunk[256];
+    for (size_t i = 0; i < count; i += sizeof(chunk)) {
+        size_t n = std::min(count - i, sizeof(chunk));
+        indices(pixels + i, n, chunk);
+        for (size_t j = 0; j < n; ++j) {
+            pixels[i + j] = bank[chunk[j]];
+        }
+    }
+}
+
+//------------------------------------------------
+// palette selection
+
+namespace {
+// the pixels that fell in one 5-5-5 bit histogram bin:
+struct Bin {
+    uint32_t count = 0;
+    uint64_t sum[4] = { 0, 0, 0, 0 }; // r, g, b, a
+
+    glm::u8vec4 mean() const
+    {
+        return glm::u8vec4((sum[0] + count / 2) / count, (sum[1] + count / 2) / count,
+            (sum[2] + count / 2) / count, (sum[3] + count / 2) / count);
+    }
+    void add(Bin const& other)
+    {
+        count += other.count;
+        for (uint32_t c = 0; c < 4; ++c) {
+            sum[c] += other.sum[c];
+        }
+    }
+};
+
+// a range of bins that median cut may split further:
+struct Box {
+    uint32_t begin, end; // into the (non-empty) bins
+    uint32_t axis; // longest channel
+    uint32_t range; // ...and its extent
+    uint64_t count; // pixels in the box
+};
+}
+
+std::vector<glm::u8vec4> choose_palette(glm::u8vec4 const* pixels, size_t count, uint32_t n, uint32_t refine_iterations)
+{
+    if (n == 0 || n > 255) {
+        throw std::runtime_error("Palettes have between 1 and 255 colours, not " + std::to_string(n) + ".");
+    }
+
+    // histogram of the (non-transparent) colours:
+    std::vector<Bin> histogram(1 << 15);
+    bool transparent = false;
+    for (size_t i = 0; i < count; ++i) {
+        glm::u8vec4 p = pixels[i];
+        if (p.a == 0) {
+            transparent = true;
+            continue;
+        }
+        Bin& bin = histogram[(p.r >> 3) | (uint32_t(p.g >> 3) << 5) | (uint32_t(p.b >> 3) << 10)];
+        bin.count++;
+        bin.sum[0] += p.r;
+        bin.sum[1] += p.g;
+        bin.sum[2] += p.b;
+        bin.sum[3] += p.a;
+    }
+    std::vector<Bin> bins;
+    std::vector<glm::u8vec4> colours; // (mean of each bin)
+    for (Bin const& bin : histogram) {
+        if (bin.count) {
+            bins.emplace_back(bin);
+            colours.emplace_back(bin.mean());
+        }
+    }
+
+    std::vector<glm::u8vec4> palette;
+    if (transparent) {
+        palette.emplace_back(0, 0, 0, 0);
+    }
+    const uint32_t wanted = n - uint32_t(palette.size());
+
+    if (!bins.empty() && wanted > 0) {
+        // median cut: keep splitting the box with the most pixels * extent at the count-weighted median
+        //  of its longest channel (bins and colours are kept in the same order)
+        std::vector<uint32_t> order(bins.size());
+        auto measure = [&](uint32_t begin, uint32_t end) {
+            Box box { begin, end, 0, 0, 0 };
+            glm::u8vec4 lo(255), hi(0);
+            for (uint32_t i = begin; i < end; ++i) {
+                lo = glm::min(lo, colours[i]);
+                hi = glm::max(hi, colours[i]);
+                box.count += bins[i].count;
+            }
+            for (uint32_t c = 0; c < 4; ++c) {
+                if (uint32_t(hi[c] - lo[c]) > box.range) {
+                    box.range = hi[c] - lo[c];
+                    box.axis = c;
+                }
+            }
+            return box;
+        };
+        std::vector<Box> boxes { measure(0, uint32_t(bins.size())) };
+        while (boxes.size() < wanted) {
+            uint32_t split = uint32_t(boxes.size());
+            uint64_t best = 0;
+            for (uint32_t i = 0; i < boxes.size(); ++i) {
+                uint64_t score = boxes[i].count * boxes[i].range;
+                if (boxes[i].end - boxes[i].begin > 1 && score > best) {
+                    best = score;
+                    split = i;
+                }
+            }
+            if (split == boxes.size()) {
+                break; // (every box is down to one bin)
+            }
+            Box box = boxes[split];
+            // sort the box's bins along its axis:
+            for (uint32_t i = box.begin; i < box.end; ++i) {
+                order[i] = i;
+            }
+            std::sort(order.begin() + box.begin, order.begin() + box.end, [&](uint32_t a, uint32_t b) {
+                return colours[a][box.axis] < colours[b][box.axis];
+            });
+            std::vector<Bin> sorted_bins;
+            std::vector<glm::u8vec4> sorted_colours;
+            for (uint32_t i = box.begin; i < box.end; ++i) {
+                sorted_bins.emplace_back(bins[order[i]]);
+                sorted_colours.emplace_back(colours[order[i]]);
+            }
+            std::copy(sorted_bins.begin(), sorted_bins.end(), bins.begin() + box.begin);
+            std::copy(sorted_colours.begin(), sorted_colours.end(), colours.begin() + box.begin);
+            // ...and cut at the median (leaving at least one bin on each side):
+            uint32_t middle = box.begin + 1;
+            uint64_t below = bins[box.begin].count;
+            while (middle + 1 < box.end && below * 2 < box.count) {
+                below += bins[middle].count;
+                middle++;
+            }
+            boxes[split] = measure(box.begin, middle);
+            boxes.emplace_back(measure(middle, box.end));
+        }
+
+        std::vector<glm::u8vec4> centres;
+        for (Box const& box : boxes) {
+            Bin total;
+            for (uint32_t i = box.begin; i < box.end; ++i) {
+                total.add(bins[i]);
+            }
+            centres.emplace_back(total.mean());
+        }
+
+        // k-means, with bins standing in for their pixels (assignment uses the SIMD path of Quantizer):
+        std::vector<uint8_t> nearest(bins.size());
+        for (uint32_t iteration = 0; iteration < refine_iterations; ++iteration) {
+            Quantizer(centres, false).indices(colours.data(), colours.size(), nearest.data());
+            std::vector<Bin> totals(centres.size());
+            for (size_t i = 0; i < bins.size(); ++i) {
+                totals[nearest[i]].add(bins[i]);
+            }
+            bool moved = false;
+            for (size_t c = 0; c < centres.size(); ++c) {
+                if (totals[c].count == 0) {
+                    continue; // (keep a centre that lost all its pixels where it was)
+                }
+                glm::u8vec4 mean = totals[c].mean();
+                moved = moved || (mean != centres[c]);
+                centres[c] = mean;
+            }
+            if (!moved) {
+                break;
+            }
+        }
+        palette.insert(palette.end(), centres.begin(), centres.end());
+    }
+
+    if (palette.empty()) {
+        palette.emplace_back(0, 0, 0, 0);
+    }
+    while (palette.size() < n) {
+        palette.emplace_back(palette.back());
+    }
+    return palette;
+}
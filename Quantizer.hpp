@@ -0,0 +1,70 @@
+#pragma once
+
+/*
+ * Quantizer -- maps colours to the closest colour (in RGBA euclidean distance) of a fixed bank.
+ *
+ * Built once per bank, then used for every pixel:
+ *  - index() looks the colour up in a table over a 16x16x16x16 grid of RGBA cells; a cell stores its
+ *    answer only if the same bank entry is closest everywhere in the cell, so the table is exact,
+ *    and colours in contested cells (near a boundary between bank entries) fall back to a direct
+ *    search. Building the table takes a few milliseconds, so it is optional;
+ *  - indices() / quantize() convert whole runs of pixels, eight at a time with SSE2 where available.
+ *
+ * Ties go to the earliest bank entry, same as the old per-pixel closest_in_bank().
+ *
+ * choose_palette() picks a bank for an image in the first place (median cut, then k-means).
+ *
+ * Usage:
+ *   Quantizer quantizer(colour_bank);
+ *   uint8_t i = quantizer.index(colour); // one colour at a time, from the table
+ *   Quantizer(colour_bank, false).quantize(data.data(), data.size()); // a whole image, no table
+ */
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Quantizer {
+    // 'with_table': build the table index() uses (not needed by indices() / quantize())
+    // NOTE: throws if the bank is empty or has more than 255 colours
+    Quantizer(std::vector<glm::u8vec4> const& bank, bool with_table = true);
+
+    // index of the closest bank colour:
+    uint8_t index(glm::u8vec4 colour) const
+    {
+        if (table.empty()) {
+            return search(colour);
+        }
+        uint8_t cell = table[(colour.r >> 4) | (colour.g & 0xf0) | (uint32_t(colour.b >> 4) << 8) | (uint32_t(colour.a & 0xf0) << 8)];
+        return cell != Contested ? cell : search(colour);
+    }
+    glm::u8vec4 operator()(glm::u8vec4 colour) const { return bank[index(colour)]; }
+
+    // closest bank colour indices of 'count' pixels:
+    void indices(glm::u8vec4 const* pixels, size_t count, uint8_t* out) const;
+    // replace 'count' pixels with their closest bank colours:
+    void quantize(glm::u8vec4* pixels, size_t count) const;
+
+    // index of the closest bank colour, without the table:
+    uint8_t search(glm::u8vec4 colour) const;
+
+    const std::vector<glm::u8vec4> bank;
+
+    // fraction of table cells with a single answer (0 without a table):
+    float coverage() const;
+
+private:
+    static constexpr uint8_t Contested = 0xff;
+    std::vector<uint8_t> table; // 16^4 cells, indexed by the top four bits of each channel (or empty)
+};
+
+// pick 'n' colours that represent the pixels well:
+//  - if any pixel has alpha == 0, the first colour is (0,0,0,0) (the PPU's transparent slot) and the
+//    rest are chosen from the other pixels;
+//  - median cut over a 5-5-5 bit histogram of the colours gives a starting palette, which
+//    'refine_iterations' rounds of (count-weighted) k-means over the histogram then improve;
+//  - if there are fewer than n distinct colours, the palette is padded with copies of its last colour.
+// NOTE: throws if n is 0 or more than 255
+std::vector<glm::u8vec4> choose_palette(glm::u8vec4 const* pixels, size_t count, uint32_t n, uint32_t refine_iterations = 4);
@@ -0,0 +1,60 @@
+#include "Replay.hpp"
+
+#include "ChunkFile.hpp"
+#include "read_write_chunk.hpp"
+
+#include <fstream>
+#include <sstream>
+
+void Replay::save(std::string const& filename) const
+{
+    assert(buttons.size() == elapsed.size());
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open replay file '" + filename + "' for writing.");
+    }
+    write_chunk("seed", std::vector<uint32_t>(1, seed), &file);
+    write_chunk("btns", buttons, &file);
+    write_chunk("dt..", elapsed, &file);
+    std::string text = config.to_text();
+    write_chunk("cfg0", std::vector<char>(text.begin(), text.end()), &file);
+    std::string pattern_text = pattern.to_text();
+    write_chunk("pat0", std::vector<char>(pattern_text.begin(), pattern_text.end()), &file);
+    if (!file) {
+        throw std::runtime_error("Failed to write replay file '" + filename + "'.");
+    }
+}
+
+Replay Replay::load(std::string const& filename)
+{
+    ChunkFile file(filename);
+
+    Replay replay;
+    ChunkView<uint32_t> seed = file.view<uint32_t>("seed");
+    if (seed.size() != 1) {
+        throw std::runtime_error("Replay file '" + filename + "' should contain exactly one seed.");
+    }
+    replay.seed = seed[0];
+    // (copied rather than viewed: "btns" is one byte per tick, so "dt.." is usually unaligned)
+    file.read("btns", &replay.buttons);
+    file.read("dt..", &replay.elapsed);
+    if (replay.buttons.size() != replay.elapsed.size()) {
+        throw std::runtime_error("Replay file '" + filename + "' has mismatched button and timestep counts.");
+    }
+    if (file.find("cfg0")) {
+        ChunkView<char> text = file.view<char>("cfg0");
+        std::istringstream config(std::string(text.begin(), text.end()));
+        replay.config = GameConfig::parse(config, filename);
+    } else {
+        replay.has_config = false;
+    }
+    if (file.find("pat0")) {
+        ChunkView<char> text = file.view<char>("pat0");
+        std::istringstream pattern(std::string(text.begin(), text.end()));
+        replay.pattern = Pattern::parse(pattern, filename);
+    } else {
+        replay.has_pattern = false;
+    }
+    return replay;
+}
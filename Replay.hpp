@@ -0,0 +1,47 @@
+#pragma once
+
+/*
+ * Replay -- a compact log of everything needed to re-run a game of Redirekt.
+ *
+ * A game is fully determined by the seed given to the random number generator
+ * plus, for every tick, the state of the Buttons and the timestep used.
+ *
+ * Replays are stored as chunks (see read_write_chunk.hpp):
+ *   "seed" -- one uint32_t, the random seed the game was started with
+ *   "btns" -- one uint8_t Button bitmask per tick (see PlayMode::get_buttons)
+ *   "dt.." -- one float timestep (seconds) per tick
+ *   "cfg0" -- char, the GameConfig the game was played with (GameConfig::to_text)
+ *   "pat0" -- char, the bullet Pattern the game was played with (Pattern::to_text; empty for none)
+ *
+ * Replays saved before "cfg0" or "pat0" existed load with has_config / has_pattern = false (they
+ * were played with whatever --config / --pattern said, usually the defaults / none).
+ */
+
+#include "Game.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct Replay {
+    uint32_t seed = 0;
+    std::vector<uint8_t> buttons; // per-tick Button bitmask
+    std::vector<float> elapsed; // per-tick timestep
+    GameConfig config; // balance values the game was played with
+    bool has_config = true;
+    Pattern pattern; // bullet pattern the game was played with (no emitters for none)
+    bool has_pattern = true;
+
+    size_t size() const { return buttons.size(); }
+
+    // append a single tick to the log:
+    void record(uint8_t tick_buttons, float tick_elapsed)
+    {
+        buttons.emplace_back(tick_buttons);
+        elapsed.emplace_back(tick_elapsed);
+    }
+
+    // NOTE: both will throw on error
+    void save(std::string const& filename) const;
+    static Replay load(std::string const& filename);
+};
@@ -0,0 +1,336 @@
+#include "Resampler.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RESAMPLER_SSE2 1
+#endif
+
+static float sinc(float x)
+{
+    if (std::abs(x) < 1e-6f) {
+        return 1.0f;
+    }
+    const float px = 3.14159265358979f * x;
+    return std::sin(px) / px;
+}
+
+Resampler::Resampler(glm::uvec2 from_, glm::uvec2 to_, Filter filter_)
+    : from(from_)
+    , to(to_)
+    , filter(filter_)
+{
+    if (from.x == 0 || from.y == 0 || to.x == 0 || to.y == 0) {
+        throw std::runtime_error("Can't resample from " + std::to_string(from.x) + "x" + std::to_string(from.y)
+            + " to " + std::to_string(to.x) + "x" + std::to_string(to.y) + ".");
+    }
+    whole_blocks = (filter == Box && from.x % to.x == 0 && from.y % to.y == 0);
+    x = make_axis(from.x, to.x, filter);
+    y = make_axis(from.y, to.y, filter);
+}
+
+Resampler::Axis Resampler::make_axis(uint32_t from, uint32_t to, Filter filter)
+{
+    Axis axis;
+    axis.start.resize(to);
+    const float scale = float(from) / float(to); // source pixels per output pixel
+    if (filter == Nearest) {
+        axis.taps = 1;
+        axis.weights.assign(to, 1.0f);
+        for (uint32_t i = 0; i < to; ++i) {
+            axis.start[i] = std::min(from - 1, uint32_t((float(i) + 0.5f) * scale));
+        }
+        return axis;
+    }
+
+    // when shrinking, the filter is stretched to cover all the source pixels under an output pixel:
+    const float stretch = std::max(1.0f, scale);
+    const float radius = (filter == Box ? 0.5f : 3.0f) * stretch;
+    axis.taps = std::min(from, uint32_t(std::ceil(2.0f * radius)) + 1);
+    axis.weights.assign(size_t(to) * axis.taps, 0.0f);
+    for (uint32_t i = 0; i < to; ++i) {
+        const float centre = (float(i) + 0.5f) * scale - 0.5f; // in source pixel coordinates
+        const int32_t lo = int32_t(std::ceil(centre - radius));
+        const int32_t hi = int32_t(std::floor(centre + radius));
+        // (the window is shifted to stay inside the source; pixels past the edges repeat the edge pixel)
+        const int32_t start = std::max(0, std::min(int32_t(from - axis.taps), lo));
+        axis.start[i] = uint32_t(start);
+        float* weights = &axis.weights[size_t(i) * axis.taps];
+        float total = 0.0f;
+        for (int32_t j = lo; j <= hi; ++j) {
+            const float t = (float(j) - centre) / stretch;
+            float w;
+            if (filter == Box) {
+                w = (t >= -0.5f && t < 0.5f) ? 1.0f : 0.0f;
+            } else {
+                w = (std::abs(t) < 3.0f) ? sinc(t) * sinc(t / 3.0f) : 0.0f;
+            }
+            const int32_t tap = std::max(0, std::min(int32_t(from) - 1, j)) - start;
+            assert(tap >= 0 && tap < int32_t(axis.taps));
+            weights[tap] += w;
+            total += w;
+        }
+        if (total == 0.0f) { // (can't happen for box or lanczos, but just in case)
+            weights[std::min(uint32_t(std::max(0.0f, centre + 0.5f)), from - 1) - start] = total = 1.0f;
+        }
+        for (uint32_t t = 0; t < axis.taps; ++t) {
+            weights[t] /= total;
+        }
+    }
+
+    // the window above is generous (e.g. 5 taps for a factor-4 box), so trim off zero weights:
+    uint32_t needed = 1;
+    for (uint32_t i = 0; i < to; ++i) {
+        float const* weights = &axis.weights[size_t(i) * axis.taps];
+        uint32_t first = 0, last = axis.taps - 1;
+        while (first < last && weights[first] == 0.0f) {
+            first++;
+        }
+        while (last > first && weights[last] == 0.0f) {
+            last--;
+        }
+        needed = std::max(needed, last - first + 1);
+    }
+    if (needed < axis.taps) {
+        Axis trimmed;
+        trimmed.taps = needed;
+        trimmed.start.resize(to);
+        trimmed.weights.assign(size_t(to) * needed, 0.0f);
+        for (uint32_t i = 0; i < to; ++i) {
+            float const* weights = &axis.weights[size_t(i) * axis.taps];
+            uint32_t first = 0;
+            while (first + 1 < axis.taps && weights[first] == 0.0f) {
+                first++;
+            }
+            const uint32_t start = std::min(axis.start[i] + first, from - needed);
+            trimmed.start[i] = start;
+            for (uint32_t t = 0; t < axis.taps; ++t) {
+                if (weights[t] != 0.0f) {
+                    trimmed.weights[size_t(i) * needed + (axis.start[i] + t - start)] = weights[t];
+                }
+            }
+        }
+        return trimmed;
+    }
+    return axis;
+}
+
+void Resampler::filter_row(glm::u8vec4 const* src, float* row_floats, float* dst) const
+{
+#if RESAMPLER_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    uint32_t p = 0;
+    for (; p + 4 <= from.x; p += 4) {
+        __m128i four;
+        std::memcpy(&four, src + p, 16);
+        __m128i lo = _mm_unpacklo_epi8(four, zero), hi = _mm_unpackhi_epi8(four, zero);
+        _mm_storeu_ps(row_floats + p * 4 + 0, _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_ps(row_floats + p * 4 + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_ps(row_floats + p * 4 + 8, _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_ps(row_floats + p * 4 + 12, _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)));
+    }
+    for (; p < from.x; ++p) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            row_floats[p * 4 + c] = float(src[p][c]);
+        }
+    }
+    for (uint32_t i = 0; i < to.x; ++i) {
+        float const* taps = row_floats + size_t(x.start[i]) * 4;
+        float const* weights = &x.weights[size_t(i) * x.taps];
+        __m128 sum = _mm_setzero_ps();
+        for (uint32_t t = 0; t < x.taps; ++t) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(taps + t * 4), _mm_set1_ps(weights[t])));
+        }
+        _mm_storeu_ps(dst + size_t(i) * 4, sum);
+    }
+#else
+    for (uint32_t p = 0; p < from.x; ++p) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            row_floats[p * 4 + c] = float(src[p][c]);
+        }
+    }
+    for (uint32_t i = 0; i < to.x; ++i) {
+        float const* taps = row_floats + size_t(x.start[i]) * 4;
+        float const* weights = &x.weights[size_t(i) * x.taps];
+        float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (uint32_t t = 0; t < x.taps; ++t) {
+            for (uint32_t c = 0; c < 4; ++c) {
+                sum[c] += taps[t * 4 + c] * weights[t];
+            }
+        }
+        for (uint32_t c = 0; c < 4; ++c) {
+            dst[i * 4 + c] = sum[c];
+        }
+    }
+#endif
+}
+
+void Resampler::resample(glm::u8vec4 const* in, glm::u8vec4* out, float* scratch) const
+{
+    static_assert(sizeof(glm::u8vec4) == 4, "pixels are packed RGBA");
+    if (whole_blocks) {
+        resample_blocks(in, out, scratch);
+        return;
+    }
+
+    // source rows are filtered along x into a ring of y.taps rows (source row s in slot s % y.taps),
+    //  each exactly once as the window of rows slides down, so scratch stays small enough for cache
+    //  and rows no output depends on (e.g. skipped by 'Nearest') are never filtered at all
+    float* row_floats = scratch + size_t(y.taps) * to.x * 4;
+    auto ring_row = [&](uint32_t s) { return scratch + size_t(s % y.taps) * to.x * 4; };
+    uint32_t held_begin = 0, held_end = 0; // source rows currently in the ring
+
+    // down columns: every output row is a weighted sum of y.taps filtered rows, walked in blocks of
+    //  columns so the running sums stay in registers / L1 whatever the width
+    const uint32_t Block = 64; // pixels
+    for (uint32_t row = 0; row < to.y; ++row) {
+        // bring the rows this output row needs into the ring (usually just the ones it adds to the window):
+        const uint32_t start = y.start[row], window_end = start + y.taps;
+        const uint32_t from_row = (start >= held_begin && start <= held_end) ? held_end : start;
+        for (uint32_t s = from_row; s < window_end; ++s) {
+            filter_row(in + size_t(s) * from.x, row_floats, ring_row(s));
+        }
+        held_begin = start;
+        held_end = window_end;
+
+        float const* weights = &y.weights[size_t(row) * y.taps];
+        glm::u8vec4* dst = out + size_t(row) * to.x;
+        for (uint32_t block = 0; block < to.x; block += Block) {
+            const uint32_t end = std::min(to.x, block + Block);
+#if RESAMPLER_SSE2
+            __m128 sums[Block];
+            for (uint32_t i = block; i < end; ++i) {
+                sums[i - block] = _mm_setzero_ps();
+            }
+            for (uint32_t t = 0; t < y.taps; ++t) {
+                const __m128 w = _mm_set1_ps(weights[t]);
+                float const* src = ring_row(start + t);
+                for (uint32_t i = block; i < end; ++i) {
+                    sums[i - block] = _mm_add_ps(sums[i - block], _mm_mul_ps(_mm_loadu_ps(src + size_t(i) * 4), w));
+                }
+            }
+            for (uint32_t i = block; i < end; ++i) {
+                // (round to nearest, then saturate to 0..255 since lanczos can overshoot)
+                __m128i px = _mm_cvtps_epi32(sums[i - block]);
+                px = _mm_packs_epi32(px, px);
+                px = _mm_packus_epi16(px, px);
+                int32_t rgba = _mm_cvtsi128_si32(px);
+                std::memcpy(reinterpret_cast<uint8_t*>(dst + i), &rgba, 4);
+            }
+#else
+            glm::vec4 sums[Block];
+            for (uint32_t i = block; i < end; ++i) {
+                sums[i - block] = glm::vec4(0.0f);
+            }
+            for (uint32_t t = 0; t < y.taps; ++t) {
+                float const* src = ring_row(start + t);
+                for (uint32_t i = block; i < end; ++i) {
+                    sums[i - block] += glm::vec4(src[i * 4 + 0], src[i * 4 + 1], src[i * 4 + 2], src[i * 4 + 3]) * weights[t];
+                }
+            }
+            for (uint32_t i = block; i < end; ++i) {
+                // (round to nearest even, like _mm_cvtps_epi32, then saturate)
+                for (uint32_t c = 0; c < 4; ++c) {
+                    dst[i][c] = uint8_t(std::min(255.0f, std::max(0.0f, std::nearbyint(sums[i - block][c]))));
+                }
+            }
+#endif
+        }
+    }
+}
+
+void Resampler::resample_blocks(glm::u8vec4 const* in, glm::u8vec4* out, float* scratch) const
+{
+    const uint32_t fx = from.x / to.x, fy = from.y / to.y;
+    const float count = float(fx) * float(fy);
+
+    // the column sums of one output row's block of source rows, from.x RGBA floats (exact integers
+    //  until a block is over 65793 pixels):
+    float* sums = scratch;
+    // source rows are added up a few columns at a time, so the sums stay in registers / L1 as the
+    //  rows stream past:
+    const uint32_t Block = 64; // pixels
+
+    for (uint32_t row = 0; row < to.y; ++row) {
+        glm::u8vec4 const* first = in + size_t(row) * fy * from.x;
+        std::fill_n(sums, size_t(from.x) * 4, 0.0f);
+        for (uint32_t block = 0; block < from.x; block += Block) {
+            const uint32_t end = std::min(from.x, block + Block);
+            uint32_t p = block;
+#if RESAMPLER_SSE2
+            // (in 16-bit lanes, this many rows at a time before they could overflow)
+            const uint32_t MaxRows = 0xffff / 0xff;
+            const __m128i zero = _mm_setzero_si128();
+            const uint32_t end4 = block + (end - block) / 4 * 4;
+            for (uint32_t r0 = 0; r0 < fy; r0 += MaxRows) {
+                const uint32_t r1 = std::min(fy, r0 + MaxRows);
+                __m128i acc[Block / 2]; // (two pixels of 16-bit lanes each)
+                for (uint32_t q = block; q < end4; q += 2) {
+                    acc[(q - block) / 2] = zero;
+                }
+                for (uint32_t r = r0; r < r1; ++r) {
+                    glm::u8vec4 const* src = first + size_t(r) * from.x;
+                    for (uint32_t q = block; q < end4; q += 4) {
+                        __m128i four;
+                        std::memcpy(&four, src + q, 16);
+                        __m128i* a = acc + (q - block) / 2;
+                        a[0] = _mm_add_epi16(a[0], _mm_unpacklo_epi8(four, zero));
+                        a[1] = _mm_add_epi16(a[1], _mm_unpackhi_epi8(four, zero));
+                    }
+                }
+                for (uint32_t q = block; q < end4; q += 2) {
+                    const __m128i a = acc[(q - block) / 2];
+                    float* dst = sums + size_t(q) * 4;
+                    _mm_storeu_ps(dst + 0, _mm_add_ps(_mm_loadu_ps(dst + 0), _mm_cvtepi32_ps(_mm_unpacklo_epi16(a, zero))));
+                    _mm_storeu_ps(dst + 4, _mm_add_ps(_mm_loadu_ps(dst + 4), _mm_cvtepi32_ps(_mm_unpackhi_epi16(a, zero))));
+                }
+            }
+            p = end4;
+#endif
+            for (; p < end; ++p) {
+                uint32_t acc[4] = { 0, 0, 0, 0 };
+                for (uint32_t r = 0; r < fy; ++r) {
+                    glm::u8vec4 const& c = first[size_t(r) * from.x + p];
+                    for (uint32_t ch = 0; ch < 4; ++ch) {
+                        acc[ch] += c[ch];
+                    }
+                }
+                for (uint32_t c = 0; c < 4; ++c) {
+                    sums[size_t(p) * 4 + c] += float(acc[c]);
+                }
+            }
+        }
+
+        // then each output pixel adds up its fx columns and divides (exactly, so halves are ties and
+        //  round to even, as in resample()):
+        glm::u8vec4* dst = out + size_t(row) * to.x;
+        for (uint32_t i = 0; i < to.x; ++i) {
+            float const* columns = sums + size_t(i) * fx * 4;
+#if RESAMPLER_SSE2
+            __m128 sum = _mm_loadu_ps(columns);
+            for (uint32_t t = 1; t < fx; ++t) {
+                sum = _mm_add_ps(sum, _mm_loadu_ps(columns + t * 4));
+            }
+            __m128i px = _mm_cvtps_epi32(_mm_div_ps(sum, _mm_set1_ps(count)));
+            px = _mm_packs_epi32(px, px);
+            px = _mm_packus_epi16(px, px);
+            int32_t rgba = _mm_cvtsi128_si32(px);
+            std::memcpy(reinterpret_cast<uint8_t*>(dst + i), &rgba, 4);
+#else
+            for (uint32_t c = 0; c < 4; ++c) {
+                float sum = columns[c];
+                for (uint32_t t = 1; t < fx; ++t) {
+                    sum += columns[t * 4 + c];
+                }
+                dst[i][c] = uint8_t(std::nearbyint(sum / count));
+            }
+#endif
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+/*
+ * Resampler -- scales RGBA images to any size, up or down, with a choice of filter.
+ *
+ * All the filter weights are worked out once, when the Resampler is made for a pair of sizes;
+ * resample() then runs two separable passes, along rows into a small ring of float rows and down
+ * columns from there into the output, interleaved so the rows in flight stay in cache, and
+ * accumulating a whole RGBA pixel per SSE2 register where available.
+ * resample() does not allocate: the caller passes the output and the scratch space.
+ *
+ * Usage:
+ *   Resampler resampler(size, glm::uvec2(8, 8), Resampler::Box);
+ *   std::vector<float> scratch(resampler.scratch_floats());
+ *   std::vector<glm::u8vec4> out(8 * 8);
+ *   resampler.resample(in.data(), out.data(), scratch.data());
+ *
+ * Box downsampling by a whole factor averages each block of pixels, as convert_to_new_size did
+ * (rounded to nearest rather than truncated). That case skips the weights entirely: source rows are
+ * widened and summed a block at a time, then each output pixel divides its block's sum.
+ */
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Resampler {
+    enum Filter {
+        Nearest, // closest source pixel
+        Box, // average of the source pixels under the output pixel
+        Lanczos3, // windowed sinc, three lobes (sharpest, may ring a little at hard edges)
+    };
+
+    // NOTE: throws if either size is zero in x or y
+    Resampler(glm::uvec2 from, glm::uvec2 to, Filter filter);
+
+    // space resample() needs (a few rows of RGBA floats):
+    size_t scratch_floats() const { return (size_t(y.taps) * to.x + from.x) * 4; }
+
+    // 'in' is from.x * from.y pixels, 'out' is to.x * to.y pixels, rows in order (any origin):
+    void resample(glm::u8vec4 const* in, glm::u8vec4* out, float* scratch) const;
+
+    const glm::uvec2 from, to;
+    const Filter filter;
+
+private:
+    // for every output coordinate along one axis, 'taps' weights starting at source coordinate 'start':
+    struct Axis {
+        uint32_t taps = 0;
+        std::vector<uint32_t> start;
+        std::vector<float> weights; // taps per output coordinate
+    };
+    static Axis make_axis(uint32_t from, uint32_t to, Filter filter);
+    Axis x, y;
+
+    // Box filter and 'to' divides 'from' on both axes, so resample() uses resample_blocks():
+    bool whole_blocks = false;
+    void resample_blocks(glm::u8vec4 const* in, glm::u8vec4* out, float* scratch) const;
+
+    // one source row, filtered along x into to.x RGBA floats ('row_floats' is from.x * 4 floats of space):
+    void filter_row(glm::u8vec4 const* src, float* row_floats, float* dst) const;
+};
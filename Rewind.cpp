@@ -0,0 +1,130 @@
+#include "Rewind.hpp"
+
+#include <cassert>
+#include <stdexcept>
+
+// Delta format: a sequence of runs, each
+//   uint16_t skip;  // bytes that didn't change
+//   uint16_t count; // followed by 'count' bytes to XOR in
+static void push_u16(std::vector<uint8_t>& to, uint32_t value)
+{
+    to.emplace_back(uint8_t(value & 0xff));
+    to.emplace_back(uint8_t(value >> 8));
+}
+
+static void encode_delta(uint8_t const* a, uint8_t const* b, size_t size, std::vector<uint8_t>* to_)
+{
+    std::vector<uint8_t>& to = *to_;
+    to.clear();
+    size_t i = 0;
+    while (i < size) {
+        size_t start = i;
+        while (i < size && a[i] == b[i] && i - start < 0xffff) {
+            i++;
+        }
+        size_t skip = i - start;
+        if (i == size) {
+            break; // (trailing zeros need no run)
+        }
+        // literal run; short stretches of zeros stay in it rather than starting a new run:
+        start = i;
+        while (i < size && i - start < 0xffff) {
+            size_t zeros = 0;
+            while (i + zeros < size && a[i + zeros] == b[i + zeros] && zeros < 4) {
+                zeros++;
+            }
+            if (zeros == 4 || i + zeros == size || i + zeros - start >= 0xffff) {
+                break;
+            }
+            i += zeros + 1;
+        }
+        push_u16(to, uint32_t(skip));
+        push_u16(to, uint32_t(i - start));
+        for (size_t j = start; j < i; ++j) {
+            to.emplace_back(uint8_t(a[j] ^ b[j]));
+        }
+    }
+}
+
+static void apply_delta(std::vector<uint8_t> const& delta, uint8_t* state)
+{
+    uint8_t const* at = delta.data();
+    uint8_t const* end = delta.data() + delta.size();
+    while (at < end) {
+        uint32_t skip = uint32_t(at[0]) | (uint32_t(at[1]) << 8);
+        uint32_t count = uint32_t(at[2]) | (uint32_t(at[3]) << 8);
+        at += 4;
+        state += skip;
+        for (uint32_t j = 0; j < count; ++j) {
+            state[j] ^= at[j];
+        }
+        state += count;
+        at += count;
+    }
+}
+
+Rewind::Rewind(size_t budget_, uint32_t interval_)
+    : budget(budget_)
+    , interval(interval_)
+{
+    if (interval == 0) {
+        throw std::runtime_error("Rewind keyframe interval must be at least one tick.");
+    }
+}
+
+uint64_t Rewind::first_tick() const
+{
+    return keyframes.empty() ? head_tick : keyframes.front().tick;
+}
+
+void Rewind::record(Game const& game, float dt)
+{
+    if (next_tick % interval == 0) {
+        if (has_head && head_tick < next_tick) {
+            keyframes.emplace_back();
+            keyframes.back().tick = head_tick;
+            encode_delta(reinterpret_cast<uint8_t const*>(&head), reinterpret_cast<uint8_t const*>(&game.state()), sizeof(GameState), &keyframes.back().delta);
+            keyframes.back().delta.shrink_to_fit();
+            delta_bytes += keyframes.back().delta.size();
+        }
+        head = game.state();
+        head_tick = next_tick;
+        has_head = true;
+    }
+    inputs.emplace_back(Input { game.get_buttons(), dt });
+    next_tick++;
+
+    // stay within budget by forgetting the oldest keyframes:
+    while (memory() > budget && !keyframes.empty()) {
+        uint64_t next = (keyframes.size() > 1 ? keyframes[1].tick : head_tick);
+        inputs.erase(inputs.begin(), inputs.begin() + (next - keyframes.front().tick));
+        delta_bytes -= keyframes.front().delta.size();
+        keyframes.pop_front();
+    }
+}
+
+void Rewind::rewind(uint64_t tick, Game* game)
+{
+    assert(has_head && first_tick() <= tick && tick <= next_tick);
+
+    // step the head back, keyframe by keyframe, to the one at or before 'tick':
+    while (head_tick > tick) {
+        assert(!keyframes.empty());
+        apply_delta(keyframes.back().delta, reinterpret_cast<uint8_t*>(&head));
+        head_tick = keyframes.back().tick;
+        delta_bytes -= keyframes.back().delta.size();
+        keyframes.pop_back();
+    }
+
+    // then re-simulate from there:
+    uint64_t first = first_tick();
+    game->restore(head);
+    for (uint64_t t = head_tick; t < tick; ++t) {
+        Input const& input = inputs[t - first];
+        game->set_buttons(input.buttons);
+        game->update(input.dt);
+    }
+
+    inputs.resize(tick - first);
+    next_tick = tick;
+}
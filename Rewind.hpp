@@ -0,0 +1,65 @@
+#pragma once
+
+/*
+ * Rewind -- a bounded history of a Game that can be rewound to any recent tick.
+ *
+ * Every 'interval' ticks the GameState is kept as a keyframe. Only the newest keyframe is
+ * stored in full; each older one is stored as the XOR of itself with the next newer keyframe,
+ * run-length encoded (most of the state doesn't change in a second, so the XOR is mostly zeros).
+ * Between keyframes only each tick's input (buttons + dt) is kept: rewinding to a tick rebuilds
+ * the keyframe at or before it and re-simulates at most 'interval' ticks, which gives exactly
+ * the same state because Game is deterministic.
+ *
+ * When the history outgrows 'budget' bytes the oldest keyframe and its inputs are dropped;
+ * deltas point from older to newer keyframes, so nothing needs to be re-encoded.
+ *
+ * Usage:
+ *   rewind.record(game, dt); // before every game.update(dt)
+ *   ...
+ *   rewind.rewind(rewind.tick() - 60, &game); // one second back (at 60Hz)
+ */
+
+#include "Game.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+struct Rewind {
+    Rewind(size_t budget = 1 << 20, uint32_t interval = 60);
+
+    // call just before every game.update(dt), once the buttons for that update are set:
+    void record(Game const& game, float dt);
+
+    // range of ticks that can be rewound to (tick n is the state after n updates):
+    uint64_t first_tick() const;
+    uint64_t tick() const { return next_tick; }
+
+    // put 'game' back the way it was at 'tick' (first_tick() <= tick <= tick())
+    //  and forget the history after it; recording continues from there:
+    void rewind(uint64_t tick, Game* game);
+
+    // bytes used by the history:
+    size_t memory() const { return sizeof(GameState) + delta_bytes + inputs.size() * sizeof(Input); }
+
+    const size_t budget;
+    const uint32_t interval;
+
+private:
+    struct Input {
+        uint8_t buttons;
+        float dt;
+    };
+    struct Keyframe {
+        uint64_t tick;
+        std::vector<uint8_t> delta; // RLE(this keyframe XOR the next newer one)
+    };
+
+    bool has_head = false;
+    uint64_t head_tick = 0; // tick of the newest keyframe
+    GameState head = GameState(0); // the newest keyframe
+    std::deque<Keyframe> keyframes; // older keyframes, oldest first
+    std::deque<Input> inputs; // input for every tick from first_tick()
+    size_t delta_bytes = 0;
+    uint64_t next_tick = 0;
+};
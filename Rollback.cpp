@@ -0,0 +1,164 @@
+#include "Rollback.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Packet format (little-endian):
+//   uint32_t now;   // sender's current tick
+//   uint32_t echo;  // newest 'now' the sender has received from us (for the round trip time)
+//   uint32_t ack;   // sender has our input for every tick before this
+//   uint32_t first; // tick of the first input below
+//   uint8_t count;  // followed by 'count' bytes of buttons, for ticks first, first+1, ...
+static constexpr size_t HeaderSize = 17;
+
+static void push_u32(std::vector<uint8_t>& to, uint32_t value)
+{
+    for (uint32_t i = 0; i < 4; ++i) {
+        to.emplace_back(uint8_t(value >> (8 * i)));
+    }
+}
+
+static uint32_t read_u32(uint8_t const* from)
+{
+    return uint32_t(from[0]) | (uint32_t(from[1]) << 8) | (uint32_t(from[2]) << 16) | (uint32_t(from[3]) << 24);
+}
+
+Rollback::Rollback(Game* game_, uint8_t local_player_, Transport* transport_, uint32_t input_delay_, float dt_)
+    : game(*game_)
+    , local_player(local_player_)
+    , transport(*transport_)
+    , input_delay(std::min(input_delay_, MaxDelay))
+    , dt(dt_)
+    , snapshots(MaxRollback, game_->state())
+{
+    remote_ticks.fill(~0u);
+    // (the first input_delay ticks have no local input)
+    local_scheduled = input_delay;
+}
+
+bool Rollback::tick(uint8_t buttons)
+{
+    receive();
+    if (next_tick >= remote_received + MaxRollback) {
+        stats.stalls++;
+        send(); // (keep acks flowing)
+        return false;
+    }
+
+    local_inputs[local_scheduled % InputWindow] = buttons;
+    local_scheduled++;
+
+    simulate(next_tick);
+    next_tick++;
+    stats.ticks++;
+    send();
+    return true;
+}
+
+void Rollback::poll()
+{
+    receive();
+    send();
+}
+
+uint32_t Rollback::suggested_delay() const
+{
+    return std::min(MaxDelay, uint32_t(std::ceil(stats.rtt / 2.0f)));
+}
+
+void Rollback::receive()
+{
+    while (transport.receive(&packet)) {
+        if (packet.size() < HeaderSize || packet.size() < HeaderSize + packet[16]) {
+            continue; // (malformed)
+        }
+        stats.packets_received++;
+        uint32_t sender_now = read_u32(&packet[0]);
+        uint32_t echo = read_u32(&packet[4]);
+        uint32_t ack = read_u32(&packet[8]);
+        uint32_t first = read_u32(&packet[12]);
+        uint32_t count = packet[16];
+
+        remote_sent_tick = std::max(remote_sent_tick, sender_now);
+        remote_acked = std::max(remote_acked, ack);
+        if (echo > echo_seen) {
+            echo_seen = echo;
+            float sample = float(next_tick - echo);
+            stats.rtt = (stats.rtt == 0.0f ? sample : 0.9f * stats.rtt + 0.1f * sample);
+        }
+
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t t = first + i;
+            if (t < remote_received || t >= remote_received + InputWindow) {
+                continue; // (already have it, or too far ahead to store)
+            }
+            uint32_t slot = t % InputWindow;
+            if (remote_ticks[slot] == t) {
+                continue;
+            }
+            remote_inputs[slot] = packet[HeaderSize + i];
+            remote_ticks[slot] = t;
+            if (t < next_tick && predicted[slot] != remote_inputs[slot]) {
+                rollback_to = std::min(rollback_to, t); // (simulated with the wrong input)
+            }
+        }
+    }
+    while (remote_ticks[remote_received % InputWindow] == remote_received) {
+        remote_received++;
+    }
+
+    // go back and fix any ticks that were simulated with a wrong prediction:
+    if (rollback_to < next_tick) {
+        auto before = std::chrono::steady_clock::now();
+        game.restore(snapshots[rollback_to % MaxRollback]);
+        for (uint32_t t = rollback_to; t < next_tick; ++t) {
+            simulate(t);
+        }
+        auto after = std::chrono::steady_clock::now();
+
+        uint32_t count = next_tick - rollback_to;
+        stats.rollbacks++;
+        stats.resimulated += count;
+        stats.max_resimulated = std::max(stats.max_resimulated, count);
+        stats.resimulate_seconds += std::chrono::duration<double>(after - before).count();
+    }
+    rollback_to = ~0u;
+}
+
+void Rollback::send()
+{
+    uint32_t first = remote_acked;
+    uint32_t count = std::min(local_scheduled - first, 255u);
+
+    packet.clear();
+    push_u32(packet, next_tick);
+    push_u32(packet, remote_sent_tick);
+    push_u32(packet, remote_received);
+    push_u32(packet, first);
+    packet.emplace_back(uint8_t(count));
+    for (uint32_t t = first; t < first + count; ++t) {
+        packet.emplace_back(local_inputs[t % InputWindow]);
+    }
+    transport.send(packet);
+    stats.packets_sent++;
+}
+
+void Rollback::simulate(uint32_t tick)
+{
+    snapshots[tick % MaxRollback] = game.state();
+
+    // the remote player's input if it's here, otherwise predict they're still holding their last known buttons:
+    uint32_t slot = tick % InputWindow;
+    uint8_t remote = 0;
+    if (remote_ticks[slot] == tick) {
+        remote = remote_inputs[slot];
+    } else if (remote_received > 0) {
+        remote = remote_inputs[(remote_received - 1) % InputWindow];
+    }
+    predicted[slot] = remote;
+
+    game.set_buttons(local_inputs[slot], local_player);
+    game.set_buttons(remote, uint8_t(1 - local_player));
+    game.update(dt);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+/*
+ * Rollback -- two-player netplay that hides latency by predicting the other player's input.
+ *
+ * Both peers run the same deterministic two-player Game in fixed ticks. Every tick:
+ *  - the local buttons are scheduled 'input_delay' ticks in the future and sent, along with every
+ *    local input the other side hasn't acknowledged yet (so lost packets are simply covered by the next);
+ *  - remote inputs that arrived are filed away; if one differs from what was predicted for its tick,
+ *    the game is restored to the snapshot taken at that tick and re-simulated with the real input;
+ *  - the game advances one tick, predicting that the remote player still holds their last known buttons.
+ *
+ * Snapshots of the last MaxRollback ticks are kept. If the remote input falls further behind than that,
+ * tick() stalls (returns false) instead of predicting any further.
+ *
+ * More input delay means fewer and shorter rollbacks, but less responsive controls: 'stats' reports
+ * how often rollbacks happen and what they cost, and suggested_delay() estimates the delay that
+ * would cover the one-way trip from the measured round trip time.
+ */
+
+#include "Game.hpp"
+#include "Transport.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+struct Rollback {
+    static constexpr uint32_t MaxRollback = 16; // ticks of snapshots kept
+    static constexpr uint32_t MaxDelay = 30; // ticks
+
+    Rollback(Game* game, uint8_t local_player, Transport* transport, uint32_t input_delay = 2, float dt = 1.0f / 60.0f);
+
+    // advance one tick with the local player holding 'buttons'; returns false (and doesn't advance)
+    //  if too far ahead of the remote player's confirmed input:
+    bool tick(uint8_t buttons);
+
+    // handle arrived packets (rolling back if needed) and keep the remote side up to date, without advancing:
+    void poll();
+
+    uint32_t now() const { return next_tick; } // ticks simulated so far
+    uint32_t confirmed() const { return remote_received; } // ticks that used the remote player's real input
+
+    uint32_t suggested_delay() const;
+
+    Game& game;
+    const uint8_t local_player;
+    Transport& transport;
+    const uint32_t input_delay;
+    const float dt;
+
+    struct Stats {
+        uint64_t ticks = 0; // ticks advanced
+        uint64_t stalls = 0; // calls to tick() that had to wait
+        uint64_t rollbacks = 0;
+        uint64_t resimulated = 0; // ticks simulated again during rollbacks
+        uint32_t max_resimulated = 0; // most ticks re-simulated by a single rollback
+        double resimulate_seconds = 0.0; // CPU time spent re-simulating
+        uint64_t packets_sent = 0;
+        uint64_t packets_received = 0;
+        float rtt = 0.0f; // round trip time estimate, in ticks
+    } stats;
+
+private:
+    static constexpr uint32_t InputWindow = 128; // ticks of input kept (power of two)
+
+    void receive(); // (and roll back if a prediction was wrong)
+    void send();
+    void simulate(uint32_t tick);
+
+    uint32_t next_tick = 0;
+    uint32_t rollback_to = ~0u; // earliest tick that was simulated with a wrong prediction
+
+    std::array<uint8_t, InputWindow> local_inputs = {};
+    uint32_t local_scheduled = 0; // local inputs are known for ticks before this
+    uint32_t remote_acked = 0; // the remote side has every local input before this tick
+
+    std::array<uint8_t, InputWindow> remote_inputs = {};
+    std::array<uint32_t, InputWindow> remote_ticks; // which tick each remote_inputs slot holds
+    std::array<uint8_t, InputWindow> predicted = {}; // remote input each tick was simulated with
+    uint32_t remote_received = 0; // remote inputs are known for every tick before this
+
+    std::vector<GameState> snapshots; // state at the start of tick t is snapshots[t % MaxRollback]
+
+    uint32_t remote_sent_tick = 0; // newest 'now' the remote side reported (echoed back for rtt)
+    uint32_t echo_seen = 0;
+    std::vector<uint8_t> packet; // (scratch space for send/receive)
+};
@@ -0,0 +1,128 @@
+#include "SpriteCache.hpp"
+
+#include "ChunkFile.hpp"
+#include "read_write_chunk.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+// FNV-1a, 64 bit:
+struct Hash {
+    uint64_t value = 0xcbf29ce484222325ULL;
+    void add(void const* data, size_t size)
+    {
+        uint8_t const* bytes = static_cast<uint8_t const*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            value = (value ^ bytes[i]) * 0x100000001b3ULL;
+        }
+    }
+    template <typename T>
+    void add(T const& t) { add(&t, sizeof(T)); }
+};
+}
+
+SpriteCache::SpriteCache(std::string const& directory_)
+    : directory(directory_)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        throw std::runtime_error("Failed to create sprite cache directory '" + directory + "': " + error.message());
+    }
+}
+
+uint64_t SpriteCache::key(std::vector<uint8_t> const& png_bytes, glm::uvec2 size,
+    std::vector<glm::u8vec4> const& colour_bank, bool multidirectional)
+{
+    Hash hash;
+    hash.add(Version);
+    hash.add(uint64_t(png_bytes.size()));
+    hash.add(png_bytes.data(), png_bytes.size());
+    hash.add(size.x);
+    hash.add(size.y);
+    hash.add(uint32_t(colour_bank.size()));
+    for (glm::u8vec4 const& colour : colour_bank) {
+        hash.add(colour);
+    }
+    hash.add(uint8_t(multidirectional));
+    return hash.value;
+}
+
+std::string SpriteCache::path(uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.sprite", (unsigned long long)key);
+    return directory + "/" + name;
+}
+
+bool SpriteCache::load(uint64_t key, std::vector<PPU466::Tile>* tiles, PPU466::Palette* palette)
+{
+    used.insert(key);
+    std::string filename = path(key);
+    if (!std::filesystem::exists(filename)) {
+        misses++;
+        return false;
+    }
+    try {
+        ChunkFile file(filename);
+        ChunkView<PPU466::Tile> tile_view = file.view<PPU466::Tile>("tile");
+        ChunkView<PPU466::Palette> palette_view = file.view<PPU466::Palette>("pal0");
+        if (tile_view.empty() || palette_view.size() != 1) {
+            throw std::runtime_error("Sprite cache entry '" + filename + "' has the wrong number of tiles or palettes.");
+        }
+        tiles->assign(tile_view.begin(), tile_view.end());
+        *palette = palette_view[0];
+    } catch (std::exception const&) {
+        // (a damaged entry is just a miss; store() will replace it)
+        misses++;
+        return false;
+    }
+    hits++;
+    return true;
+}
+
+void SpriteCache::store(uint64_t key, std::vector<PPU466::Tile> const& tiles, PPU466::Palette const& palette)
+{
+    used.insert(key);
+    std::string filename = path(key);
+    // (written under another name and then renamed, so a partly-written entry is never read)
+    std::string temp = filename + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary);
+        write_chunk("tile", tiles, &file);
+        write_chunk("pal0", std::vector<PPU466::Palette>(1, palette), &file);
+        if (!file) {
+            throw std::runtime_error("Failed to write sprite cache entry '" + temp + "'.");
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temp, filename, error);
+    if (error) {
+        throw std::runtime_error("Failed to write sprite cache entry '" + filename + "': " + error.message());
+    }
+}
+
+uint32_t SpriteCache::prune()
+{
+    uint32_t removed = 0;
+    for (auto const& entry : std::filesystem::directory_iterator(directory)) {
+        std::string name = entry.path().filename().string();
+        if (!entry.is_regular_file() || name.size() != 16 + 7 || name.substr(16) != ".sprite") {
+            continue; // (not ours)
+        }
+        uint64_t key = 0;
+        try {
+            key = std::stoull(name.substr(0, 16), nullptr, 16);
+        } catch (std::exception const&) {
+            continue;
+        }
+        if (!used.count(key)) {
+            std::filesystem::remove(entry.path());
+            removed++;
+        }
+    }
+    return removed;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+/*
+ * SpriteCache -- converted sprites (tiles + palette), on disk, keyed by a hash of everything the
+ * conversion depends on: the PNG's bytes, the target size, the colour bank, whether rotations are
+ * made, and SpriteCache::Version.
+ *
+ * dist/pack-sprites looks every sprite up before decoding and converting it, so with a warm cache
+ * only the PNGs (or bank entries) that actually changed are converted again.
+ *
+ * Invalidation:
+ *  - editing a PNG or its line in the sprite list changes the key, so the old entry is just not used;
+ *  - changing how sprites are converted (load_save_png.cpp, SpriteData) must bump Version;
+ *  - entries that can't be read back (truncated, wrong sizes) count as misses and are replaced;
+ *  - prune() deletes every entry not used since the cache was opened (dist/pack-sprites --prune).
+ *
+ * Each entry is a file "<key as 16 hex digits>.sprite" holding chunks "tile" (PPU466::Tile) and
+ * "pal0" (one PPU466::Palette).
+ */
+
+#include "PPU466.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+struct SpriteCache {
+    // bump whenever the conversion from PNG to tiles changes:
+    static constexpr uint32_t Version = 2; // 2: Resampler rounds averages instead of truncating
+
+    // (creates the directory if needed)
+    // NOTE: throws on error
+    SpriteCache(std::string const& directory);
+
+    static uint64_t key(std::vector<uint8_t> const& png_bytes, glm::uvec2 size,
+        std::vector<glm::u8vec4> const& colour_bank, bool multidirectional);
+
+    // true (and fills tiles + palette) on a hit:
+    bool load(uint64_t key, std::vector<PPU466::Tile>* tiles, PPU466::Palette* palette);
+    void store(uint64_t key, std::vector<PPU466::Tile> const& tiles, PPU466::Palette const& palette);
+
+    // delete entries that weren't loaded or stored since the cache was opened; returns how many:
+    uint32_t prune();
+
+    const std::string directory;
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+
+private:
+    std::string path(uint64_t key) const;
+    std::unordered_set<uint64_t> used;
+};
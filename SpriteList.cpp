@@ -0,0 +1,113 @@
+#include "SpriteList.hpp"
+
+#include "SpriteCache.hpp"
+#include "Sprites.hpp"
+#include "load_save_png.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+static glm::u8vec4 parse_colour(std::string const& hex)
+{
+    if (hex.size() != 8 || hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+        throw std::runtime_error("Expecting a colour as RRGGBBAA, not '" + hex + "'.");
+    }
+    uint32_t rgba = uint32_t(std::stoul(hex, nullptr, 16));
+    return glm::u8vec4(rgba >> 24, (rgba >> 16) & 0xff, (rgba >> 8) & 0xff, rgba & 0xff);
+}
+
+SpriteList::SpriteList(std::string const& filename_, std::string const& root_)
+    : filename(filename_)
+    , root(root_)
+{
+    std::ifstream list(filename);
+    if (!list) {
+        throw std::runtime_error("Failed to open sprite list '" + filename + "'.");
+    }
+    std::unordered_set<std::string> names;
+    std::string line;
+    uint32_t line_number = 0;
+    while (std::getline(list, line)) {
+        line_number++;
+        std::istringstream tokens(line.substr(0, line.find('#')));
+        Entry entry;
+        entry.rotations = 0;
+        std::vector<std::string> hex;
+        if (!(tokens >> entry.name)) {
+            continue; // blank line
+        }
+        tokens >> entry.png >> entry.rotations;
+        for (std::string h; tokens >> h;) {
+            hex.emplace_back(h);
+        }
+        bool auto_bank = (hex.size() == 1 && hex[0] == "auto");
+        if (!tokens.eof() || (entry.rotations != 1 && entry.rotations != 4) || (hex.size() != 4 && !auto_bank)) {
+            throw std::runtime_error(filename + " line " + std::to_string(line_number) + ": expecting '<name> <png> <1 or 4> <colour> <colour> <colour> <colour>' or '<name> <png> <1 or 4> auto'");
+        }
+        if (!names.insert(entry.name).second) {
+            throw std::runtime_error(filename + " line " + std::to_string(line_number) + ": sprite '" + entry.name + "' is listed twice.");
+        }
+        if (!auto_bank) {
+            for (std::string const& h : hex) {
+                entry.colour_bank.emplace_back(parse_colour(h));
+            }
+        }
+        entries.emplace_back(entry);
+    }
+}
+
+std::string SpriteList::png_path(Entry const& entry) const
+{
+    return root.empty() ? entry.png : root + "/" + entry.png;
+}
+
+void SpriteList::convert(Entry const& entry, std::vector<PPU466::Tile>* tiles, PPU466::Palette* palette, SpriteCache* cache) const
+{
+    const glm::uvec2 tile_size(8, 8);
+    const std::string png = png_path(entry);
+    uint64_t key = 0;
+    if (cache) {
+        std::ifstream png_file(png, std::ios::binary);
+        if (!png_file) {
+            throw std::runtime_error("Failed to open '" + png + "'.");
+        }
+        std::vector<uint8_t> png_bytes((std::istreambuf_iterator<char>(png_file)), std::istreambuf_iterator<char>());
+        key = SpriteCache::key(png_bytes, tile_size, entry.colour_bank, entry.rotations == 4);
+        if (cache->load(key, tiles, palette)) {
+            return;
+        }
+    }
+
+    glm::uvec2 size;
+    std::vector<glm::u8vec4> data;
+    load_png(png, &size, &data);
+    std::vector<glm::u8vec4> colour_bank = entry.colour_bank;
+    if (colour_bank.empty()) {
+        // pick the four colours from the downsampled sprite itself:
+        convert_to_new_size(tile_size, size, data);
+        convert_to_n_colours(4, size, data.data(), colour_bank);
+    } else {
+        convert_to_new_size_with_bank(tile_size, size, data, colour_bank);
+    }
+    SpriteData sd(data, colour_bank, entry.rotations == 4);
+    *tiles = std::move(sd.bits);
+    *palette = sd.colours;
+    if (cache) {
+        cache->store(key, *tiles, *palette);
+    }
+}
+
+Sprites SpriteList::pack(SpriteCache* cache) const
+{
+    Sprites sprites;
+    std::vector<PPU466::Tile> tiles;
+    PPU466::Palette palette;
+    for (Entry const& entry : entries) {
+        convert(entry, &tiles, &palette, cache);
+        sprites.add(entry.name, tiles, palette);
+    }
+    return sprites;
+}
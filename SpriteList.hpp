@@ -0,0 +1,51 @@
+#pragma once
+
+/*
+ * SpriteList -- a list of sprites to bake (see assets/sprites.txt), and the conversion of each
+ * from its PNG into tiles and a palette.
+ *
+ * dist/pack-sprites bakes a whole list into a Sprites file; SpriteHotReload (see HotReload.hpp)
+ * converts single entries again while the game runs.
+ *
+ * Every line names a sprite, the PNG it comes from, how many rotations to make (1 or 4), and the
+ * four colours (RRGGBBAA) to match its pixels against -- or 'auto' to choose them from the image.
+ * PNG paths are relative to 'root' (the working directory, if root is empty).
+ */
+
+#include "PPU466.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SpriteCache;
+struct Sprites;
+
+struct SpriteList {
+    struct Entry {
+        std::string name;
+        std::string png; // (as written in the list)
+        uint32_t rotations = 1;
+        std::vector<glm::u8vec4> colour_bank; // (empty for 'auto')
+
+        bool operator==(Entry const& other) const
+        {
+            return name == other.name && png == other.png && rotations == other.rotations && colour_bank == other.colour_bank;
+        }
+    };
+
+    // NOTE: throws if the list can't be read, or on a malformed line (naming the line)
+    SpriteList(std::string const& filename, std::string const& root = "");
+
+    const std::string filename, root;
+    std::vector<Entry> entries;
+
+    std::string png_path(Entry const& entry) const;
+
+    // decode, downsample to 8x8 and colour-match one sprite (looked up in / stored to 'cache' if given):
+    //  NOTE: throws if the PNG can't be loaded
+    void convert(Entry const& entry, std::vector<PPU466::Tile>* tiles, PPU466::Palette* palette, SpriteCache* cache = nullptr) const;
+
+    // every sprite in the list, in order:
+    Sprites pack(SpriteCache* cache = nullptr) const;
+};
@@ -0,0 +1,82 @@
+#include "Sprites.hpp"
+
+#include "ChunkFile.hpp"
+#include "read_write_chunk.hpp"
+
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+Sprites::Sprites(std::string const& filename)
+{
+    ChunkFile file(filename);
+    ChunkView<char> names = file.view<char>("str0");
+    std::vector<Entry> entries;
+    file.read("spr0", &entries); // (copied, since files from before str0 was padded may leave it unaligned)
+    ChunkView<PPU466::Tile> tile_view = file.view<PPU466::Tile>("tile");
+    ChunkView<PPU466::Palette> palette_view = file.view<PPU466::Palette>("pal0");
+    tiles.assign(tile_view.begin(), tile_view.end());
+    palettes.assign(palette_view.begin(), palette_view.end());
+
+    for (Entry const& entry : entries) {
+        if (entry.name_begin > entry.name_end || entry.name_end > names.size()
+            || entry.tile_count == 0 || entry.first_tile + entry.tile_count > tiles.size()
+            || entry.palette >= palettes.size()) {
+            throw std::runtime_error("Sprites file '" + filename + "' has a sprite that is out of range.");
+        }
+        std::string name(names.begin() + entry.name_begin, names.begin() + entry.name_end);
+        sprites[name] = Sprite { entry.first_tile, entry.tile_count, entry.palette };
+    }
+}
+
+Sprites::Sprite const& Sprites::lookup(std::string const& name) const
+{
+    auto found = sprites.find(name);
+    if (found == sprites.end()) {
+        throw std::runtime_error("No sprite named '" + name + "'.");
+    }
+    return found->second;
+}
+
+void Sprites::add(std::string const& name, std::vector<PPU466::Tile> const& sprite_tiles, PPU466::Palette const& palette)
+{
+    if (sprites.count(name)) {
+        throw std::runtime_error("Sprite '" + name + "' is listed twice.");
+    }
+    Sprite sprite;
+    sprite.first_tile = uint32_t(tiles.size());
+    sprite.tile_count = uint32_t(sprite_tiles.size());
+    sprite.palette = uint32_t(palettes.size());
+    tiles.insert(tiles.end(), sprite_tiles.begin(), sprite_tiles.end());
+    palettes.emplace_back(palette);
+    sprites[name] = sprite;
+}
+
+void Sprites::save(std::string const& filename) const
+{
+    std::vector<char> names;
+    std::vector<Entry> entries;
+    // (sorted by name, so the same sprites always make the same file)
+    std::map<std::string, Sprite> sorted(sprites.begin(), sprites.end());
+    for (auto const& [name, sprite] : sorted) {
+        Entry entry;
+        entry.name_begin = uint32_t(names.size());
+        names.insert(names.end(), name.begin(), name.end());
+        entry.name_end = uint32_t(names.size());
+        entry.first_tile = sprite.first_tile;
+        entry.tile_count = sprite.tile_count;
+        entry.palette = sprite.palette;
+        entries.emplace_back(entry);
+    }
+    // (padded so the chunks after it stay 4-byte aligned, for ChunkFile::view)
+    names.resize((names.size() + 3) / 4 * 4, '\0');
+
+    std::ofstream file(filename, std::ios::binary);
+    write_chunk("str0", names, &file);
+    write_chunk("spr0", entries, &file);
+    write_chunk("tile", tiles, &file);
+    write_chunk("pal0", palettes, &file);
+    if (!file) {
+        throw std::runtime_error("Failed to write sprites file '" + filename + "'.");
+    }
+}
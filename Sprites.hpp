@@ -0,0 +1,60 @@
+#pragma once
+
+/*
+ * Sprites -- PPU-ready tiles and palettes, baked from PNGs ahead of time.
+ *
+ * dist/pack-sprites reads a list of sprites (see assets/sprites.txt), decodes, downsamples and
+ * colour-matches every PNG, and writes the resulting tiles and palettes with write_chunk;
+ * at runtime they are read straight back out of a ChunkFile, without libpng or any conversion.
+ *
+ * File format (chunks, in order):
+ *   "str0": char -- all the sprite names, back to back (zero-padded to a multiple of 4 bytes)
+ *   "spr0": Sprites::Entry -- per sprite: its name (as a range of str0), its tiles and its palette
+ *   "tile": PPU466::Tile -- tiles of all the sprites (a sprite's rotations are consecutive)
+ *   "pal0": PPU466::Palette -- one palette per sprite
+ */
+
+#include "PPU466.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Sprites {
+    Sprites() = default;
+    // NOTE: throws on error
+    Sprites(std::string const& filename);
+
+    struct Sprite {
+        uint32_t first_tile = 0; // into tiles
+        uint32_t tile_count = 0; // (1, or 4 for the rotations 0, 90, 180 and 270 degrees clockwise)
+        uint32_t palette = 0; // into palettes
+
+        PPU466::Tile const& tile(Sprites const& sprites, uint32_t rotation = 0) const
+        {
+            return sprites.tiles[first_tile + std::min(rotation, tile_count - 1)];
+        }
+    };
+
+    // NOTE: throws if there is no sprite named 'name'
+    Sprite const& lookup(std::string const& name) const;
+
+    std::vector<PPU466::Tile> tiles;
+    std::vector<PPU466::Palette> palettes;
+    std::unordered_map<std::string, Sprite> sprites;
+
+    // append a sprite's tiles (its rotations, in order) and palette:
+    //  NOTE: throws if there is already a sprite named 'name'
+    void add(std::string const& name, std::vector<PPU466::Tile> const& sprite_tiles, PPU466::Palette const& palette);
+
+    void save(std::string const& filename) const;
+
+    // (as stored in "spr0")
+    struct Entry {
+        uint32_t name_begin, name_end;
+        uint32_t first_tile, tile_count;
+        uint32_t palette;
+    };
+    static_assert(sizeof(Entry) == 20, "Entry is packed");
+};
@@ -0,0 +1,128 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace {
+// which pool (and which worker in it) the current thread belongs to:
+thread_local ThreadPool const* current_pool = nullptr;
+thread_local uint32_t current_worker = 0;
+}
+
+ThreadPool::ThreadPool(uint32_t count)
+{
+    if (count == 0) {
+        count = std::max(1U, std::thread::hardware_concurrency());
+    }
+    workers.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        workers.emplace_back(std::make_unique<Worker>());
+    }
+    threads.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        threads.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stop = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::push(std::function<void()> const& job)
+{
+    uint32_t target;
+    if (current_pool == this) {
+        target = current_worker;
+    } else {
+        target = next_worker.fetch_add(1, std::memory_order_relaxed) % size();
+    }
+
+    unfinished.fetch_add(1);
+    {
+        Worker& worker = *workers[target];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.jobs.emplace_back(job);
+    }
+    queued.fetch_add(1);
+
+    // taking the lock means a worker can't miss this between checking 'queued' and sleeping:
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    assert(current_pool != this && "waiting from inside a job would deadlock");
+    std::unique_lock<std::mutex> lock(sleep_mutex);
+    done.wait(lock, [this]() { return unfinished.load() == 0; });
+}
+
+void ThreadPool::parallel_for(size_t count, std::function<void(size_t)> const& fn)
+{
+    for (size_t i = 0; i < count; ++i) {
+        push([&fn, i]() { fn(i); });
+    }
+    wait();
+}
+
+bool ThreadPool::pop(uint32_t worker, std::function<void()>* job)
+{
+    { // own queue, newest first:
+        Worker& own = *workers[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            *job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    // steal from everyone else, oldest first:
+    for (uint32_t offset = 1; offset < size(); ++offset) {
+        Worker& victim = *workers[(worker + offset) % size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            *job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            queued.fetch_sub(1);
+            steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::work(uint32_t worker)
+{
+    current_pool = this;
+    current_worker = worker;
+
+    std::function<void()> job;
+    while (true) {
+        if (pop(worker, &job)) {
+            job();
+            job = nullptr;
+            if (unfinished.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(sleep_mutex);
+                done.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake.wait(lock, [this]() { return stop || queued.load() > 0; });
+        if (stop && queued.load() == 0) {
+            break;
+        }
+    }
+}
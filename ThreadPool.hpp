@@ -0,0 +1,65 @@
+#pragma once
+
+/*
+ * ThreadPool -- a fixed set of worker threads that run jobs.
+ *
+ * Every worker has its own queue of jobs:
+ *  - jobs pushed from a worker go on that worker's own queue;
+ *  - jobs pushed from any other thread are dealt out round-robin;
+ *  - a worker takes from the back of its own queue (most recently pushed, likely still in cache)
+ *    and, when that is empty, steals from the front of the other workers' queues.
+ *
+ * Usage:
+ *   ThreadPool pool(8);
+ *   pool.parallel_for(games.size(), [&](size_t i) { run(games[i]); });
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct ThreadPool {
+    // threads == 0 means "one per hardware thread":
+    ThreadPool(uint32_t threads = 0);
+    ~ThreadPool();
+
+    uint32_t size() const { return uint32_t(workers.size()); }
+
+    // add a job (jobs may push more jobs):
+    void push(std::function<void()> const& job);
+
+    // block until every job pushed so far (and any jobs they push) has run:
+    void wait();
+
+    // run fn(i) for every i in [0, count) and wait for all of them:
+    void parallel_for(size_t count, std::function<void(size_t)> const& fn);
+
+    // jobs that ended up running on a different worker than they were queued on:
+    std::atomic<uint64_t> steals { 0 };
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+    };
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    bool pop(uint32_t worker, std::function<void()>* job);
+    void work(uint32_t worker);
+
+    std::atomic<uint32_t> next_worker { 0 }; // round-robin target for pushes from outside the pool
+    std::atomic<size_t> queued { 0 }; // jobs sitting in queues
+    std::atomic<size_t> unfinished { 0 }; // jobs pushed but not yet completed
+    bool stop = false; // guarded by sleep_mutex
+
+    std::mutex sleep_mutex;
+    std::condition_variable wake; // signalled when a job is queued (or on shutdown)
+    std::condition_variable done; // signalled when 'unfinished' reaches zero
+};
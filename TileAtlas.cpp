@@ -0,0 +1,127 @@
+#include "TileAtlas.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+TileAtlas::TileAtlas(uint32_t first_, uint32_t count_)
+    : first(first_)
+    , count(count_)
+{
+    if (first + count > 256 || count == 0) {
+        throw std::runtime_error("TileAtlas slots [" + std::to_string(first) + ", " + std::to_string(first + count) + ") don't fit in the tile table.");
+    }
+}
+
+TileAtlas::Key TileAtlas::key(PPU466::Tile const& tile)
+{
+    static_assert(sizeof(PPU466::Tile) == 16, "Tile is two 8-byte bit planes");
+    Key k;
+    std::memcpy(&k.first, tile.bit0.data(), 8);
+    std::memcpy(&k.second, tile.bit1.data(), 8);
+    return k;
+}
+
+PPU466::Tile TileAtlas::transform(PPU466::Tile const& tile, uint32_t t)
+{
+    auto get = [](PPU466::Tile const& from, uint32_t x, uint32_t y) {
+        return ((from.bit0[y] >> x) & 1) | (((from.bit1[y] >> x) & 1) << 1);
+    };
+    PPU466::Tile result = tile;
+    for (uint32_t turn = 0; turn < (t & 3); ++turn) {
+        PPU466::Tile turned;
+        for (uint32_t y = 0; y < 8; ++y) {
+            uint8_t bit0 = 0, bit1 = 0;
+            for (uint32_t x = 0; x < 8; ++x) {
+                uint32_t index = get(result, 7 - y, x);
+                bit0 |= uint8_t((index & 1) << x);
+                bit1 |= uint8_t((index >> 1) << x);
+            }
+            turned.bit0[y] = bit0;
+            turned.bit1[y] = bit1;
+        }
+        result = turned;
+    }
+    if (t & 4) {
+        for (uint32_t y = 0; y < 8; ++y) {
+            // (reverse the bits of every row)
+            auto reverse = [](uint8_t b) {
+                b = uint8_t((b & 0xf0) >> 4 | (b & 0x0f) << 4);
+                b = uint8_t((b & 0xcc) >> 2 | (b & 0x33) << 2);
+                return uint8_t((b & 0xaa) >> 1 | (b & 0x55) << 1);
+            };
+            result.bit0[y] = reverse(result.bit0[y]);
+            result.bit1[y] = reverse(result.bit1[y]);
+        }
+    }
+    return result;
+}
+
+uint8_t TileAtlas::add(PPU466::Tile const& tile)
+{
+    added++;
+    const Key exact = key(tile);
+    auto found = slots.find(exact);
+    if (found != slots.end()) {
+        duplicates++;
+        return found->second;
+    }
+    if (tiles.size() >= count) {
+        throw std::runtime_error("TileAtlas is full (" + std::to_string(count) + " tiles).");
+    }
+
+    Key shape = exact;
+    for (uint32_t t = 1; t < 8; ++t) {
+        shape = std::min(shape, key(transform(tile, t)));
+    }
+    uint32_t& same_shape = shapes[shape];
+    if (same_shape > 0) {
+        transformed++;
+    }
+    same_shape++;
+
+    uint8_t slot = uint8_t(first + tiles.size());
+    tiles.emplace_back(tile);
+    slots.emplace(exact, slot);
+    return slot;
+}
+
+std::vector<uint8_t> TileAtlas::add_image(glm::uvec2 size, uint8_t const* indices)
+{
+    if (size.x % 8 != 0 || size.y % 8 != 0) {
+        throw std::runtime_error("TileAtlas images must be a multiple of 8 pixels across, not " + std::to_string(size.x) + "x" + std::to_string(size.y) + ".");
+    }
+    std::vector<uint8_t> map;
+    map.reserve(size_t(size.x / 8) * (size.y / 8));
+    for (uint32_t ty = 0; ty < size.y / 8; ++ty) {
+        for (uint32_t tx = 0; tx < size.x / 8; ++tx) {
+            PPU466::Tile tile;
+            for (uint32_t y = 0; y < 8; ++y) {
+                uint8_t const* row = indices + size_t(ty * 8 + y) * size.x + tx * 8;
+                uint8_t bit0 = 0, bit1 = 0;
+                for (uint32_t x = 0; x < 8; ++x) {
+                    bit0 |= uint8_t((row[x] & 1) << x);
+                    bit1 |= uint8_t(((row[x] >> 1) & 1) << x);
+                }
+                tile.bit0[y] = bit0;
+                tile.bit1[y] = bit1;
+            }
+            map.emplace_back(add(tile));
+        }
+    }
+    return map;
+}
+
+void TileAtlas::upload(std::array<PPU466::Tile, 16 * 16>* tile_table) const
+{
+    std::copy(tiles.begin(), tiles.end(), tile_table->begin() + first);
+}
+
+std::string TileAtlas::report() const
+{
+    char buffer[160];
+    std::snprintf(buffer, sizeof(buffer), "%u of %u tiles (%.1f%%) for %u added: %u duplicates, %u more the same up to rotation / mirror",
+        uint32_t(tiles.size()), count, 100.0f * utilization(), added, duplicates, transformed);
+    return buffer;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+/*
+ * TileAtlas -- hands out PPU466 tile table slots, sharing one slot between identical tiles.
+ *
+ * Sprites (and their rotations) and background images are added tile by tile; each add() returns
+ * the slot the tile ended up in, and add_image() returns a map of slots for every 8x8 block of an
+ * image. Tiles are keyed by their 16 bytes of bits, so exact duplicates always share a slot.
+ *
+ * Tiles that are only the same up to a rotation or mirror still need their own slot (PPU466
+ * sprites and background entries can't be flipped or rotated), but they are counted, so report()
+ * shows how many slots a renderer that could flip tiles would save.
+ *
+ * Usage:
+ *   TileAtlas atlas;
+ *   uint8_t slot = atlas.add(tile);
+ *   std::vector<uint8_t> map = atlas.add_image(size, colour_indices);
+ *   atlas.upload(&ppu.tile_table);
+ */
+
+#include "PPU466.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct TileAtlas {
+    // hands out slots [first, first + count) of the tile table:
+    TileAtlas(uint32_t first = 0, uint32_t count = 256);
+
+    // the slot holding 'tile' (a new one, or one already holding the same bits):
+    //  NOTE: throws if every slot is taken
+    uint8_t add(PPU466::Tile const& tile);
+
+    // split an image of colour indices (0-3, size a multiple of 8, rows in PPU order -- bottom to top)
+    //  into tiles; returns the slot of every 8x8 block, row by row:
+    //  NOTE: throws if the size isn't a multiple of 8, or the atlas fills up
+    std::vector<uint8_t> add_image(glm::uvec2 size, uint8_t const* indices);
+
+    // copy the tiles into their slots:
+    void upload(std::array<PPU466::Tile, 16 * 16>* tile_table) const;
+
+    // 't & 3' quarter turns, then a mirror if 't & 4' (so the eight symmetries of a square):
+    static PPU466::Tile transform(PPU466::Tile const& tile, uint32_t t);
+
+    const uint32_t first, count;
+    std::vector<PPU466::Tile> tiles; // tiles[i] goes in slot first + i
+
+    uint32_t added = 0; // calls to add() (including through add_image())
+    uint32_t duplicates = 0; // ...that found the same bits already in a slot
+    uint32_t transformed = 0; // ...that got a new slot, though a rotation / mirror of them already had one
+
+    float utilization() const { return float(tiles.size()) / float(count); }
+    // e.g. "12 of 256 tiles (4.7%) for 40 added: 26 duplicates, 2 more the same up to rotation / mirror"
+    std::string report() const;
+
+private:
+    typedef std::pair<uint64_t, uint64_t> Key; // (all of a tile's bits)
+    struct KeyHash {
+        size_t operator()(Key const& key) const { return size_t(key.first * 0x9e3779b97f4a7c15ULL ^ key.second); }
+    };
+    static Key key(PPU466::Tile const& tile);
+
+    std::unordered_map<Key, uint8_t, KeyHash> slots; // exact bits -> slot
+    std::unordered_map<Key, uint32_t, KeyHash> shapes; // smallest key among a tile's symmetries -> tiles with it
+};
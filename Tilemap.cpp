@@ -0,0 +1,204 @@
+#include "Tilemap.hpp"
+
+#include "ChunkFile.hpp"
+#include "read_write_chunk.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+Tilemap::Tilemap(std::string const& filename)
+{
+    ChunkFile file(filename);
+    std::vector<Header> header;
+    file.read("tmp0", &header);
+    if (header.size() != 1) {
+        throw std::runtime_error("Tilemap file '" + filename + "' should have exactly one header.");
+    }
+    width = header[0].width;
+    height = header[0].height;
+    file.read("tmz0", &encoded);
+
+    if (file.find("tml0")) {
+        ChunkView<char> names = file.view<char>("str0");
+        std::vector<LegendEntry> entries;
+        file.read("tml0", &entries);
+        if (entries.size() > 256) {
+            throw std::runtime_error("Tilemap file '" + filename + "' has more than 256 legend entries.");
+        }
+        for (LegendEntry const& entry : entries) {
+            if (entry.name_begin > entry.name_end || entry.name_end > names.size()
+                || (entry.rotation > 3 && entry.rotation != FollowsAim)) {
+                throw std::runtime_error("Tilemap file '" + filename + "' has a legend entry that is out of range.");
+            }
+            legend.emplace_back();
+            legend.back().sprite.assign(names.begin() + entry.name_begin, names.begin() + entry.name_end);
+            legend.back().rotation = entry.rotation;
+        }
+    }
+}
+
+void Tilemap::save(std::string const& filename) const
+{
+    std::ofstream file(filename, std::ios::binary);
+    write_chunk("tmp0", std::vector<Header> { Header { width, height } }, &file);
+    write_chunk("tmz0", encoded, &file);
+    if (!legend.empty()) {
+        std::vector<char> names;
+        std::vector<LegendEntry> entries;
+        for (Tile const& tile : legend) {
+            LegendEntry entry;
+            entry.name_begin = uint32_t(names.size());
+            names.insert(names.end(), tile.sprite.begin(), tile.sprite.end());
+            entry.name_end = uint32_t(names.size());
+            entry.rotation = tile.rotation;
+            entries.emplace_back(entry);
+        }
+        // (padded so the chunk after it stays 4-byte aligned)
+        names.resize((names.size() + 3) / 4 * 4, '\0');
+        write_chunk("str0", names, &file);
+        write_chunk("tml0", entries, &file);
+    }
+    if (!file) {
+        throw std::runtime_error("Failed to write tilemap file '" + filename + "'.");
+    }
+}
+
+Tilemap Tilemap::encode(uint32_t width, uint32_t height, uint16_t const* entries)
+{
+    Tilemap tilemap;
+    tilemap.width = width;
+    tilemap.height = height;
+    std::vector<uint16_t>& out = tilemap.encoded;
+
+    // how far back Above looks (repeats further apart than this are left to Run / Literal):
+    const uint32_t MaxRowsUp = 8;
+    // ops shorter than this aren't worth splitting a literal for (a Run or Above is two words):
+    const uint32_t MinMatch = 3;
+
+    for (uint32_t y = 0; y < height; ++y) {
+        uint16_t const* row = entries + size_t(y) * width;
+
+        // the best op starting at column x: (kind, length, rows up)
+        auto best_at = [&](uint32_t x, uint32_t* length, uint32_t* rows_up) {
+            const uint32_t limit = std::min(width - x, uint32_t(MaxCount));
+            uint32_t run = 1;
+            while (run < limit && row[x + run] == row[x]) {
+                run++;
+            }
+            uint32_t above = 0, above_rows = 0;
+            for (uint32_t up = 1; up <= std::min(y, MaxRowsUp); ++up) {
+                uint16_t const* from = row - size_t(up) * width;
+                uint32_t match = 0;
+                while (match < limit && from[x + match] == row[x + match]) {
+                    match++;
+                }
+                if (match > above) {
+                    above = match;
+                    above_rows = up;
+                }
+            }
+            if (above >= run) {
+                *length = above;
+                *rows_up = above_rows;
+                return Above;
+            }
+            *length = run;
+            *rows_up = 0;
+            return Run;
+        };
+
+        uint32_t x = 0;
+        while (x < width) {
+            uint32_t length, rows_up;
+            uint16_t kind = best_at(x, &length, &rows_up);
+            if (length >= MinMatch || (length == width - x && length >= 2)) {
+                out.emplace_back(uint16_t((kind << 14) | (length - 1)));
+                out.emplace_back(kind == Run ? row[x] : uint16_t(rows_up));
+                x += length;
+                continue;
+            }
+            // otherwise entries go out as they are, until something repeats again:
+            uint32_t begin = x;
+            x += 1;
+            while (x < width && x - begin < MaxCount) {
+                best_at(x, &length, &rows_up);
+                if (length >= MinMatch) {
+                    break;
+                }
+                x += 1;
+            }
+            out.emplace_back(uint16_t((Literal << 14) | (x - begin - 1)));
+            out.insert(out.end(), row + begin, row + x);
+        }
+    }
+    return tilemap;
+}
+
+void Tilemap::decode(uint16_t* out, size_t stride) const
+{
+    TilemapDecoder decoder(*this);
+    decoder.decode_rows(out, stride, height);
+}
+
+TilemapDecoder::TilemapDecoder(uint32_t width_, uint32_t height_, uint16_t const* words, size_t count)
+    : width(width_)
+    , height(height_)
+    , at(words)
+    , end(words + count)
+{
+}
+
+TilemapDecoder::TilemapDecoder(Tilemap const& tilemap)
+    : TilemapDecoder(tilemap.width, tilemap.height, tilemap.encoded.data(), tilemap.encoded.size())
+{
+}
+
+uint32_t TilemapDecoder::decode_rows(uint16_t* out, size_t stride, uint32_t rows)
+{
+    if (stride < width) {
+        throw std::runtime_error("Tilemap rows are " + std::to_string(width) + " entries wide, more than the stride of " + std::to_string(stride) + ".");
+    }
+    auto malformed = [this]() {
+        return std::runtime_error("Tilemap data is malformed at row " + std::to_string(row) + ".");
+    };
+
+    const uint32_t stop = std::min(height, row + rows);
+    const uint32_t first = row;
+    for (; row < stop; ++row) {
+        uint16_t* dst = out + size_t(row) * stride;
+        uint32_t x = 0;
+        while (x < width) {
+            if (end - at < 2) {
+                throw malformed();
+            }
+            const uint16_t op = at[0];
+            const uint32_t kind = op >> 14, count = (op & (Tilemap::MaxCount - 1)) + 1u;
+            if (count > width - x) {
+                throw malformed();
+            }
+            if (kind == Tilemap::Run) {
+                std::fill_n(dst + x, count, at[1]);
+                at += 2;
+            } else if (kind == Tilemap::Literal) {
+                if (size_t(end - at) < 1 + size_t(count)) {
+                    throw malformed();
+                }
+                std::memcpy(dst + x, at + 1, count * sizeof(uint16_t));
+                at += 1 + count;
+            } else if (kind == Tilemap::Above) {
+                const uint32_t up = at[1];
+                if (up == 0 || up > row) {
+                    throw malformed();
+                }
+                std::memcpy(dst + x, dst + x - size_t(up) * stride, count * sizeof(uint16_t));
+                at += 2;
+            } else {
+                throw malformed();
+            }
+            x += count;
+        }
+    }
+    return row - first;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+/*
+ * Tilemap -- a grid of PPU466 background entries (tile index in bits 0-7, palette in bits 8-10),
+ * compressed for storage and decoded straight into PPU466::background (or a larger world map).
+ *
+ * Encoding: a stream of uint16_t words, one op after another, row by row (bottom row first, as in
+ * PPU466::background). Every op starts with a word (kind << 14) | (count - 1), covers 'count'
+ * entries (1 to 16384), and never runs past the end of a row:
+ *   Run     (kind 0): one more word, the entry, repeated 'count' times;
+ *   Literal (kind 1): 'count' more words, the entries;
+ *   Above   (kind 2): one more word, 'rows' (1 or more): copy 'count' entries from the same
+ *                     columns that many rows down (rows already decoded).
+ * Ops stopping at row ends means a row only depends on earlier rows, so rows can be decoded a few
+ * at a time, into any destination stride, each op being a fill or a memcpy.
+ *
+ * A map may come with a legend, naming what its tile indices stand for (sprite + rotation) rather
+ * than which tile table slots they use: the game resolves those to slots once its sprites are in
+ * place (see PlayMode::use_sprites), so levels don't depend on how the tile table gets packed.
+ *
+ * File format (chunks, in order):
+ *   "tmp0": Tilemap::Header -- width and height, in tiles
+ *   "tmz0": uint16_t -- the encoded words
+ *   "str0": char -- (if there is a legend) the sprite names, back to back (zero-padded to a multiple of 4 bytes)
+ *   "tml0": Tilemap::LegendEntry -- (if there is a legend) per tile index: its sprite name (as a range of str0) and rotation
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct Tilemap {
+    uint32_t width = 0, height = 0;
+    std::vector<uint16_t> encoded;
+
+    // what each tile index (bits 0-7 of an entry) stands for; empty if they are tile table slots:
+    struct Tile {
+        std::string sprite;
+        uint32_t rotation = 0; // quarter turns clockwise (0-3), or FollowsAim
+    };
+    std::vector<Tile> legend;
+
+    Tilemap() = default;
+    // NOTE: throws on error
+    Tilemap(std::string const& filename);
+
+    // compress width x height entries (rows in order, 'width' apart):
+    static Tilemap encode(uint32_t width, uint32_t height, uint16_t const* entries);
+
+    void save(std::string const& filename) const;
+
+    // decode every row into 'out', row y at out + y * stride (stride >= width):
+    //  NOTE: throws if the encoded words are malformed
+    void decode(uint16_t* out, size_t stride) const;
+
+    enum : uint16_t {
+        Run = 0,
+        Literal = 1,
+        Above = 2,
+        MaxCount = 1 << 14,
+    };
+
+    // a legend rotation that isn't fixed: the game turns the tile whichever way the player aims
+    static constexpr uint32_t FollowsAim = 0xff;
+
+    // (as stored in "tmp0")
+    struct Header {
+        uint32_t width, height;
+    };
+    static_assert(sizeof(Header) == 8, "Header is packed");
+
+    // (as stored in "tml0")
+    struct LegendEntry {
+        uint32_t name_begin, name_end;
+        uint32_t rotation;
+    };
+    static_assert(sizeof(LegendEntry) == 12, "LegendEntry is packed");
+};
+
+// decodes a Tilemap's words a few rows at a time, without allocating or copying the input (so
+//  'words' can just as well point into a ChunkFile):
+struct TilemapDecoder {
+    TilemapDecoder(uint32_t width, uint32_t height, uint16_t const* words, size_t count);
+    TilemapDecoder(Tilemap const& tilemap);
+
+    // decode up to 'rows' more rows into 'out' (row y of the map at out + y * stride); returns how
+    //  many were decoded. Every call must use the same out + stride, since Above ops read back
+    //  from rows decoded by earlier calls.
+    //  NOTE: throws if the words are malformed (nothing outside the map's rows is ever written)
+    uint32_t decode_rows(uint16_t* out, size_t stride, uint32_t rows);
+
+    bool done() const { return row == height; }
+
+    const uint32_t width, height;
+    uint32_t row = 0; // next row to decode
+
+private:
+    uint16_t const* at;
+    uint16_t const* end;
+};
@@ -0,0 +1,179 @@
+#pragma once
+
+/*
+ * TimingWheel -- timers with O(1) schedule and cancel, and amortized O(1) advance.
+ *
+ * Time is counted in whole ticks (the owner decides how long a tick is). Every pending timer sits
+ * in one slot of a hierarchy of wheels:
+ *  - level 0 has a slot for each of the next 64 ticks,
+ *  - level 1 a slot for each of the next 64 blocks of 64 ticks, and so on,
+ * so scheduling just picks a slot by how far away the timer is and links the timer in.
+ * Advancing by one tick fires level 0's slot for that tick; every 64 ticks the next level 1 slot is
+ * emptied down into level 0 (and likewise up the levels), so a timer is moved at most Levels - 1
+ * times in its life. Advancing while no timers are pending is free.
+ *
+ * Timers are kept in a fixed-capacity pool and linked by index, so a TimingWheel of a trivially
+ * copyable Payload is itself trivially copyable (and can live in GameState). Timers are named by
+ * the same generation-checked Handle as EntityPool entities, so cancelling a timer that already
+ * fired is harmless.
+ *
+ * Usage:
+ *   TimingWheel<Kind, 64> timers;
+ *   Handle h = timers.schedule(timers.now + 120, TargetKind);
+ *   timers.advance(tick, [&](Kind kind) { spawn(kind); });
+ */
+
+#include "EntityPool.hpp" // for Handle
+
+#include <array>
+#include <cstdint>
+
+template <typename Payload, uint32_t Capacity>
+struct TimingWheel {
+    static_assert(Capacity < 0xffff, "timers must fit in a Handle");
+    static constexpr uint32_t SlotBits = 6;
+    static constexpr uint32_t Slots = 1 << SlotBits;
+    static constexpr uint32_t Levels = 3; // (reaches 2^18 ticks ahead; later timers wait at the top and are re-filed)
+
+    TimingWheel()
+    {
+        heads.fill(None);
+        tails.fill(None);
+        for (uint32_t i = 0; i < Capacity; ++i) {
+            timers[i].next = uint16_t(i + 1 < Capacity ? i + 1 : None);
+            timers[i].list = None;
+            timers[i].generation = 0;
+        }
+    }
+
+    uint32_t now = 0; // current tick: every timer due at or before it has fired
+    uint32_t count = 0; // pending timers
+
+    bool full() const { return count == Capacity; }
+
+    // start a timer that fires once 'when' is reached (a 'when' already past fires on the next tick);
+    //  returns Handle() if full:
+    Handle schedule(uint32_t when, Payload const& payload)
+    {
+        if (free_head == None) {
+            return Handle();
+        }
+        uint16_t i = free_head;
+        free_head = timers[i].next;
+        Timer& timer = timers[i];
+        timer.when = (when > now ? when : now + 1);
+        timer.payload = payload;
+        file(i);
+        count++;
+        return Handle { i, timer.generation };
+    }
+
+    bool pending(Handle h) const { return h.slot < Capacity && timers[h.slot].generation == h.generation && timers[h.slot].list != None; }
+
+    // stop a timer before it fires; returns false if it already fired (or was cancelled):
+    bool cancel(Handle h)
+    {
+        if (!pending(h)) {
+            return false;
+        }
+        unlink(h.slot);
+        release(h.slot);
+        return true;
+    }
+
+    // advance to tick 'to', calling fire(payload) for each timer that comes due, earliest first
+    //  (fire may schedule or cancel timers):
+    template <typename Fire>
+    void advance(uint32_t to, Fire&& fire)
+    {
+        while (now < to) {
+            if (count == 0) {
+                now = to; // (nothing to fire or move down)
+                return;
+            }
+            now++;
+            // move timers down from the levels whose current slot just changed, highest first:
+            uint32_t wrapped = 0;
+            while (wrapped + 1 < Levels && (now & ((1u << (SlotBits * (wrapped + 1))) - 1)) == 0) {
+                wrapped++;
+            }
+            for (uint32_t level = wrapped; level > 0; --level) {
+                uint32_t list = level * Slots + ((now >> (SlotBits * level)) & (Slots - 1));
+                uint16_t i = heads[list];
+                heads[list] = tails[list] = None;
+                while (i != None) {
+                    uint16_t next = timers[i].next;
+                    file(i);
+                    i = next;
+                }
+            }
+            // fire everything in this tick's slot:
+            uint32_t list = now & (Slots - 1);
+            while (heads[list] != None) {
+                uint16_t i = heads[list];
+                unlink(i);
+                Payload payload = timers[i].payload;
+                release(i);
+                fire(payload);
+            }
+        }
+    }
+
+private:
+    static constexpr uint16_t None = 0xffff;
+
+    struct Timer {
+        uint32_t when;
+        Payload payload;
+        uint16_t prev, next; // within its list (or the free list)
+        uint16_t list; // which slot's list it is in (None if free)
+        uint16_t generation; // bumped every time it fires or is cancelled
+    };
+    std::array<Timer, Capacity> timers;
+    std::array<uint16_t, Levels * Slots> heads; // first/last timer in each slot (level * Slots + slot)
+    std::array<uint16_t, Levels * Slots> tails;
+    uint16_t free_head = 0;
+
+    // put timer i in the slot for its deadline (appending, so equal deadlines fire in the order scheduled):
+    void file(uint16_t i)
+    {
+        Timer& timer = timers[i];
+        uint32_t delta = timer.when - now;
+        uint32_t level = 0;
+        while (level + 1 < Levels && delta >= (1u << (SlotBits * (level + 1)))) {
+            level++;
+        }
+        // (too far for the top level: park it in the top level's last slot and re-file it when that comes up)
+        uint32_t when = timer.when;
+        if (delta >= (1u << (SlotBits * Levels))) {
+            when = now + (1u << (SlotBits * Levels)) - 1;
+        }
+        uint16_t list = uint16_t(level * Slots + ((when >> (SlotBits * level)) & (Slots - 1)));
+        timer.list = list;
+        timer.next = None;
+        timer.prev = tails[list];
+        if (tails[list] != None) {
+            timers[tails[list]].next = i;
+        } else {
+            heads[list] = i;
+        }
+        tails[list] = i;
+    }
+
+    void unlink(uint16_t i)
+    {
+        Timer& timer = timers[i];
+        (timer.prev != None ? timers[timer.prev].next : heads[timer.list]) = timer.next;
+        (timer.next != None ? timers[timer.next].prev : tails[timer.list]) = timer.prev;
+    }
+
+    void release(uint16_t i)
+    {
+        Timer& timer = timers[i];
+        timer.list = None;
+        timer.generation++;
+        timer.next = free_head;
+        free_head = i;
+        count--;
+    }
+};
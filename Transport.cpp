@@ -0,0 +1,40 @@
+#include "Transport.hpp"
+
+#include <algorithm>
+
+LoopbackLink::LoopbackLink(Settings const& settings_, uint64_t seed)
+    : settings(settings_)
+    , rng(seed, 2)
+{
+    for (uint32_t side = 0; side < 2; ++side) {
+        endpoints[side].link = this;
+        endpoints[side].side = side;
+    }
+}
+
+void LoopbackLink::Endpoint::send(std::vector<uint8_t> const& packet)
+{
+    auto uniform = [this]() { return float(link->rng() >> 8) / float(1 << 24); };
+    link->sent++;
+    if (uniform() < link->settings.loss) {
+        link->lost++;
+        return;
+    }
+    double arrival = link->time + link->settings.latency + uniform() * link->settings.jitter;
+    link->in_flight[1 - side].emplace_back(Packet { arrival, packet });
+}
+
+bool LoopbackLink::Endpoint::receive(std::vector<uint8_t>* packet)
+{
+    // deliver the earliest packet that has arrived by now (jitter can reorder packets):
+    std::vector<Packet>& queue = link->in_flight[side];
+    auto first = std::min_element(queue.begin(), queue.end(), [](Packet const& a, Packet const& b) {
+        return a.arrival < b.arrival;
+    });
+    if (first == queue.end() || first->arrival > link->time) {
+        return false;
+    }
+    *packet = std::move(first->data);
+    queue.erase(first);
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+/*
+ * Transport -- moves packets between two netplay peers.
+ *
+ * Delivery is unreliable and unordered (like UDP): packets may be late, reordered or lost,
+ * and Rollback copes with all three. Real networking plugs in by implementing send/receive.
+ *
+ * LoopbackLink connects two in-process endpoints and simulates latency, jitter and loss on
+ * its own clock (advanced explicitly), so tests with it are repeatable.
+ */
+
+#include "Game.hpp" // for Random
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+struct Transport {
+    virtual ~Transport() { }
+
+    virtual void send(std::vector<uint8_t> const& packet) = 0;
+
+    // fetch the next packet that has arrived (returns false if there are none):
+    virtual bool receive(std::vector<uint8_t>* packet) = 0;
+};
+
+struct LoopbackLink {
+    struct Settings {
+        float latency = 0.05f; // one-way delay, seconds
+        float jitter = 0.0f; // extra delay, uniform in [0, jitter] seconds
+        float loss = 0.0f; // fraction of packets dropped
+    };
+    LoopbackLink(Settings const& settings, uint64_t seed = 0);
+
+    // the two ends of the link:
+    Transport& a() { return endpoints[0]; }
+    Transport& b() { return endpoints[1]; }
+
+    void advance(float dt) { time += dt; }
+    double time = 0.0;
+
+    const Settings settings;
+    uint64_t sent = 0;
+    uint64_t lost = 0;
+
+private:
+    struct Packet {
+        double arrival;
+        std::vector<uint8_t> data;
+    };
+    struct Endpoint : Transport {
+        LoopbackLink* link = nullptr;
+        uint32_t side = 0;
+        void send(std::vector<uint8_t> const& packet) override;
+        bool receive(std::vector<uint8_t>* packet) override;
+    };
+    std::array<Endpoint, 2> endpoints;
+    std::array<std::vector<Packet>, 2> in_flight; // packets on their way to each side
+    Random rng;
+};
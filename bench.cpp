@@ -0,0 +1,669 @@
+// bench -- micro-benchmarks for the simulation.
+//
+// Usage:
+//   dist/bench [name ...]
+//
+// Runs the named benchmarks (or all of them, if none are named) and prints a short report for each.
+
+#include "Bot.hpp"
+#include "Bullets.hpp"
+#include "ChunkFile.hpp"
+#include "Game.hpp"
+#include "Kinetic.hpp"
+#include "Quantizer.hpp"
+#include "Resampler.hpp"
+#include "Rewind.hpp"
+#include "Tilemap.hpp"
+#include "TimingWheel.hpp"
+#include "read_write_chunk.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static double milliseconds_since(Clock::time_point before)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - before).count();
+}
+
+//------------------------------------------------
+// bullets: stress test for the bullet pool + emitters.
+//  a grid of emitters keeps well over 10k bullets alive; every frame fires the pattern,
+//  moves and culls the bullets, and collides them against a moving siphon and four targets.
+
+static void bench_bullets()
+{
+    static constexpr uint32_t Capacity = 16384;
+    std::unique_ptr<BulletPool<Capacity>> pool = std::make_unique<BulletPool<Capacity>>();
+
+    Pattern pattern;
+    for (uint32_t y = 0; y < 4; ++y) {
+        for (uint32_t x = 0; x < 8; ++x) {
+            Emitter e;
+            e.kind = ((x + y) % 2 ? Emitter::Spiral : Emitter::Radial);
+            e.pos = glm::vec2(16.f + 32.f * x, 30.f + 60.f * y);
+            e.count = 48;
+            e.speed = 12.f;
+            e.period = 0.1f;
+            e.repeats = 100000;
+            e.param = 7.f;
+            pattern.emitters.emplace_back(e);
+        }
+    }
+
+    PatternPlayer player;
+    const float dt = 1.0f / 60.0f;
+    const uint32_t frames = 1200;
+
+    std::vector<double> frame_ms;
+    uint32_t peak = 0;
+    uint64_t bullet_frames = 0; // sum of live bullets over the measured frames
+    uint64_t hits = 0;
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+        float t = frame * dt;
+        glm::vec2 siphon_prev = glm::vec2(128.f + 100.f * std::sin(t - dt), 120.f);
+        glm::vec2 siphon = glm::vec2(128.f + 100.f * std::sin(t), 120.f);
+
+        auto before = Clock::now();
+        player.update(dt, pattern, siphon, pool.get());
+        pool->update(dt);
+        pool->collide(siphon_prev, siphon, dt, [&](uint32_t i, float toi) {
+            pool->vx[i] = -pool->vx[i];
+            pool->vy[i] = -pool->vy[i];
+            hits++;
+        });
+        for (uint32_t target = 0; target < 4; ++target) {
+            glm::vec2 pos = glm::vec2(40.f + 60.f * target, 20.f + 50.f * std::cos(t + target));
+            glm::vec2 prev = glm::vec2(40.f + 60.f * target, 20.f + 50.f * std::cos(t - dt + target));
+            pool->collide(prev, pos, dt, [&](uint32_t i, float toi) {
+                pool->despawn(i);
+                hits++;
+            });
+        }
+        double ms = milliseconds_since(before);
+
+        // only measure once the screen has filled up:
+        if (frame >= frames / 4) {
+            frame_ms.emplace_back(ms);
+            bullet_frames += pool->count;
+        }
+        peak = std::max(peak, pool->count);
+    }
+
+    std::sort(frame_ms.begin(), frame_ms.end());
+    double mean = 0.0;
+    for (double ms : frame_ms) {
+        mean += ms;
+    }
+    mean /= frame_ms.size();
+    double mean_bullets = double(bullet_frames) / frame_ms.size();
+
+    std::printf("bullets: %u frames, %.0f bullets on average (peak %u, capacity %u), %llu hits\n",
+        uint32_t(frame_ms.size()), mean_bullets, peak, Capacity, (unsigned long long)hits);
+    std::printf("  frame time: mean %.3f ms, median %.3f ms, max %.3f ms (budget 16 ms)\n",
+        mean, frame_ms[frame_ms.size() / 2], frame_ms.back());
+    std::printf("  throughput: %.1f M bullet-updates/sec\n", mean_bullets / mean / 1000.0);
+}
+
+//------------------------------------------------
+// snapshot: cost of saving and restoring the whole simulation state.
+//  plays a game part way (so the pools are populated), then measures plain snapshot/restore
+//  pairs and a one-tick lookahead (snapshot, update, restore) as a bot or rollback would use it.
+
+static void bench_snapshot()
+{
+    Game game(1234);
+    Random input(1234, 1);
+    const float dt = 1.0f / 60.0f;
+    for (uint32_t tick = 0; tick < 600; ++tick) {
+        game.set_buttons(uint8_t(input()));
+        game.update(dt);
+    }
+
+    // a handful of slots, so the copies can't be optimized into nothing:
+    static constexpr uint32_t Slots = 8;
+    std::vector<GameState> slots(Slots, game.state());
+
+    const uint32_t pairs = 2000000;
+    auto before = Clock::now();
+    for (uint32_t i = 0; i < pairs; ++i) {
+        slots[i % Slots] = game.state();
+        game.restore(slots[(i + 3) % Slots]);
+    }
+    double pair_ms = milliseconds_since(before);
+
+    const uint32_t lookaheads = 200000;
+    int checksum = 0;
+    before = Clock::now();
+    for (uint32_t i = 0; i < lookaheads; ++i) {
+        slots[0] = game.state();
+        game.set_buttons(uint8_t(i));
+        game.update(dt);
+        checksum += game.score;
+        game.restore(slots[0]);
+    }
+    double lookahead_ms = milliseconds_since(before);
+
+    std::printf("snapshot: %u bytes of state\n", uint32_t(sizeof(GameState)));
+    std::printf("  snapshot+restore: %.1f ns per pair, %.2f M pairs/sec\n",
+        pair_ms * 1e6 / pairs, pairs / pair_ms / 1000.0);
+    std::printf("  one-tick lookahead: %.1f ns each, %.2f M/sec (checksum %d)\n",
+        lookahead_ms * 1e6 / lookaheads, lookaheads / lookahead_ms / 1000.0, checksum);
+}
+
+//------------------------------------------------
+// rewind: memory used per second of history, and how long it takes to rewind.
+//  records a whole game (with and without a bullet pattern) with an unbounded budget,
+//  then rewinds to random earlier ticks, latest first.
+
+static void bench_rewind()
+{
+    Pattern pattern;
+    for (uint32_t i = 0; i < 4; ++i) {
+        Emitter e;
+        e.kind = (i % 2 ? Emitter::Spiral : Emitter::Aimed);
+        e.pos = glm::vec2(32.f + 64.f * i, 200.f);
+        e.count = 8;
+        e.speed = 40.f;
+        e.period = 0.5f;
+        e.repeats = 1000;
+        e.param = 30.f;
+        pattern.emitters.emplace_back(e);
+    }
+
+    for (bool bullets : { false, true }) {
+        const float dt = 1.0f / 60.0f;
+        const uint32_t interval = 60;
+        Game game(1234);
+        if (bullets) {
+            game.pattern = &pattern;
+        }
+        Rewind rewind(size_t(1) << 30, interval);
+        Random input(1234, 1);
+        while (!game.over()) {
+            game.set_buttons(uint8_t(input()));
+            rewind.record(game, dt);
+            game.update(dt);
+        }
+        const uint64_t ticks = rewind.tick();
+        const double seconds = ticks * dt;
+        const size_t bytes = rewind.memory();
+
+        std::vector<uint64_t> targets;
+        for (uint32_t i = 0; i < 100; ++i) {
+            targets.emplace_back(input() % ticks);
+        }
+        std::sort(targets.rbegin(), targets.rend());
+        std::vector<double> seek_ms;
+        for (uint64_t tick : targets) {
+            auto before = Clock::now();
+            rewind.rewind(tick, &game);
+            seek_ms.emplace_back(milliseconds_since(before));
+        }
+        std::sort(seek_ms.begin(), seek_ms.end());
+
+        std::printf("rewind%s: %.0f s of history (keyframe every %u ticks) in %.1f KB, %.2f KB per second (full state %.1f KB per second)\n",
+            bullets ? " (with bullets)" : "", seconds, interval, bytes / 1024.0, bytes / 1024.0 / seconds,
+            sizeof(GameState) / 1024.0 / dt);
+        std::printf("  seek: median %.3f ms, max %.3f ms\n", seek_ms[seek_ms.size() / 2], seek_ms.back());
+    }
+}
+
+//------------------------------------------------
+// kinetic: per-tick Game against the event-driven KineticGame.
+//  plays the same seeds and random input with both, at the usual 60Hz and at 600Hz (where
+//  per-tick polling costs ten times as much but the number of events stays the same),
+//  with the default config and one with the entity pools full.
+
+static void bench_kinetic()
+{
+    GameConfig crowded;
+    crowded.projectiles = Game::MaxProjectiles;
+    crowded.targets = Game::MaxTargets / 2;
+    crowded.super_targets = Game::MaxTargets / 2;
+
+    const uint32_t games = 200;
+    std::printf("kinetic: %u games each, random input\n", games);
+    std::printf("  config    rate   tick us/game   kinetic us/game   speedup   events/game (stale)   score tick / kinetic\n");
+    for (auto const& [name, config] : { std::make_pair("default", GameConfig()), std::make_pair("crowded", crowded) }) {
+        for (float hz : { 60.0f, 600.0f }) {
+            const float dt = 1.0f / hz;
+            double tick_ms = 0.0, kinetic_ms = 0.0;
+            int64_t tick_score = 0, kinetic_score = 0;
+            KineticGame::Stats stats;
+            for (uint32_t g = 0; g < games; ++g) {
+                // (input holds are counted in ticks, so scale them to keep the same pace at any rate)
+                const uint32_t hold = uint32_t(hz / 60.0f);
+                {
+                    RandomInput input(g);
+                    Game game(g, 1, config);
+                    auto before = Clock::now();
+                    for (uint32_t tick = 0; !game.over(); ++tick) {
+                        if (tick % hold == 0) {
+                            game.set_buttons(input.next());
+                        }
+                        game.update(dt);
+                    }
+                    tick_ms += milliseconds_since(before);
+                    tick_score += game.score;
+                }
+                {
+                    RandomInput input(g);
+                    KineticGame game(g, 1, config);
+                    auto before = Clock::now();
+                    for (uint32_t tick = 0; !game.over(); ++tick) {
+                        if (tick % hold == 0) {
+                            game.set_buttons(input.next());
+                        }
+                        game.update(dt);
+                    }
+                    kinetic_ms += milliseconds_since(before);
+                    kinetic_score += game.score;
+                    stats.events += game.stats.events;
+                    stats.stale += game.stats.stale;
+                }
+            }
+            std::printf("  %-7s  %4.0fHz  %12.1f   %15.1f   %6.2fx   %11.1f (%5.1f)   %9.2f / %.2f\n",
+                name, hz, 1000.0 * tick_ms / games, 1000.0 * kinetic_ms / games, tick_ms / kinetic_ms,
+                double(stats.events) / games, double(stats.stale) / games,
+                double(tick_score) / games, double(kinetic_score) / games);
+        }
+    }
+}
+
+//------------------------------------------------
+// timers: per-frame cost of a TimingWheel against scanning a list of deadlines (as respawns used to).
+//  keeps N timers pending, each restarted with a random 0-10 s delay when it fires, and advances
+//  one 60Hz frame (16 or 17 millisecond ticks) at a time.
+
+static void bench_timers()
+{
+    static constexpr uint32_t Capacity = 60000;
+    const uint32_t frames = 6000;
+    std::printf("timers: %u frames, timers restart with a 0-10 s delay\n", frames);
+    std::printf("  pending   fired/frame   wheel ns/frame   scan ns/frame\n");
+    for (uint32_t pending : { 100U, 1000U, 10000U, Capacity }) {
+        Random rng(pending);
+        auto delay = [&rng]() { return 1 + rng() % 10000; };
+        auto ms_at = [](uint32_t frame) { return frame * 1000 / 60; };
+
+        auto wheel = std::make_unique<TimingWheel<uint32_t, Capacity>>();
+        for (uint32_t i = 0; i < pending; ++i) {
+            wheel->schedule(delay(), i);
+        }
+        uint64_t fired = 0;
+        auto before = Clock::now();
+        for (uint32_t frame = 1; frame <= frames; ++frame) {
+            wheel->advance(ms_at(frame), [&](uint32_t i) {
+                fired++;
+                wheel->schedule(wheel->now + delay(), i);
+            });
+        }
+        double wheel_ms = milliseconds_since(before);
+
+        std::vector<uint32_t> deadlines(pending);
+        for (uint32_t& when : deadlines) {
+            when = delay();
+        }
+        before = Clock::now();
+        for (uint32_t frame = 1; frame <= frames; ++frame) {
+            const uint32_t now = ms_at(frame);
+            for (uint32_t& when : deadlines) {
+                if (when <= now) {
+                    when = now + delay();
+                }
+            }
+        }
+        double scan_ms = milliseconds_since(before);
+
+        std::printf("  %7u   %11.1f   %14.0f   %13.0f\n",
+            pending, double(fired) / frames, wheel_ms * 1e6 / frames, scan_ms * 1e6 / frames);
+    }
+}
+
+//------------------------------------------------
+// chunks: opening a large chunk file and reading a few scattered elements of its last chunk,
+//  with read_chunk (which reads and copies every chunk up to it) against ChunkFile (which maps the
+//  file and indexes the headers). the file is written to the working directory and removed after.
+
+static void bench_chunks()
+{
+    const std::string filename = "bench-chunks.tmp";
+    const uint32_t chunk_count = 8;
+    const uint32_t per_chunk = 1 << 21; // uint32_t's, so 8 MiB per chunk
+    const uint32_t lookups = 1000;
+    const uint32_t runs = 10;
+    {
+        std::ofstream file(filename, std::ios::binary);
+        std::vector<uint32_t> data(per_chunk);
+        for (uint32_t c = 0; c < chunk_count; ++c) {
+            for (uint32_t i = 0; i < per_chunk; ++i) {
+                data[i] = c * per_chunk + i;
+            }
+            write_chunk("dat" + std::to_string(c), data, &file);
+        }
+    }
+    const std::string last = "dat" + std::to_string(chunk_count - 1);
+    std::printf("chunks: %u chunks of %u KiB, %u lookups in the last one, best of %u\n",
+        chunk_count, per_chunk * 4 / 1024, lookups, runs);
+
+    double stream_ms = 1e30, mapped_ms = 1e30;
+    uint64_t stream_sum = 0, mapped_sum = 0;
+    for (uint32_t run = 0; run < runs; ++run) {
+        Random rng(run);
+        auto before = Clock::now();
+        {
+            std::ifstream file(filename, std::ios::binary);
+            std::vector<uint32_t> data;
+            for (uint32_t c = 0; c < chunk_count; ++c) {
+                read_chunk(file, "dat" + std::to_string(c), &data);
+            }
+            for (uint32_t i = 0; i < lookups; ++i) {
+                stream_sum += data[rng() % data.size()];
+            }
+        }
+        stream_ms = std::min(stream_ms, milliseconds_since(before));
+
+        rng = Random(run);
+        before = Clock::now();
+        {
+            ChunkFile file(filename);
+            ChunkView<uint32_t> data = file.view<uint32_t>(last);
+            for (uint32_t i = 0; i < lookups; ++i) {
+                mapped_sum += data[rng() % data.size()];
+            }
+        }
+        mapped_ms = std::min(mapped_ms, milliseconds_since(before));
+    }
+    std::remove(filename.c_str());
+
+    std::printf("  read_chunk: %8.3f ms\n", stream_ms);
+    std::printf("  ChunkFile:  %8.3f ms (%.0fx)%s\n", mapped_ms, stream_ms / mapped_ms,
+        stream_sum == mapped_sum ? "" : " MISMATCH");
+}
+
+//------------------------------------------------
+// quantize: snapping a 1024x1024 image (gradients + noise) to the closest colour of a bank, with the
+//  old per-pixel search (float distances, glm::length) against Quantizer's table and SSE2 paths.
+
+static void bench_quantize()
+{
+    const uint32_t width = 1024, height = 1024;
+    const uint32_t runs = 5;
+    std::vector<glm::u8vec4> image(width * height);
+    Random rng(0x5eed);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            uint32_t noise = rng();
+            image[x + width * y] = glm::u8vec4(
+                (x / 4 + (noise & 0xf)) & 0xff, (y / 4 + ((noise >> 4) & 0xf)) & 0xff,
+                ((x + y) / 8 + ((noise >> 8) & 0xf)) & 0xff, (noise >> 12) & 1 ? 0xff : 0x00);
+        }
+    }
+    std::printf("quantize: %ux%u image, best of %u\n", width, height, runs);
+    std::printf("  bank   table coverage   per pixel Mpx/s   table Mpx/s   sse2 Mpx/s\n");
+    for (uint32_t colours : { 4U, 16U, 64U }) {
+        std::vector<glm::u8vec4> bank;
+        for (uint32_t i = 0; i < colours; ++i) {
+            uint32_t c = rng();
+            bank.emplace_back(c & 0xff, (c >> 8) & 0xff, (c >> 16) & 0xff, (c >> 24) & 1 ? 0xff : 0x00);
+        }
+        auto before = Clock::now();
+        Quantizer quantizer(bank);
+        double build_ms = milliseconds_since(before);
+
+        std::vector<uint8_t> reference(image.size()), table(image.size()), simd(image.size());
+        double reference_ms = 1e30, table_ms = 1e30, simd_ms = 1e30;
+        for (uint32_t run = 0; run < runs; ++run) {
+            // (as closest_in_bank used to do it)
+            before = Clock::now();
+            for (size_t i = 0; i < image.size(); ++i) {
+                float best = 1e9f;
+                for (uint32_t b = 0; b < bank.size(); ++b) {
+                    float dist = glm::length(glm::vec4(bank[b]) - glm::vec4(image[i]));
+                    if (dist < best) {
+                        best = dist;
+                        reference[i] = uint8_t(b);
+                    }
+                }
+            }
+            reference_ms = std::min(reference_ms, milliseconds_since(before));
+
+            before = Clock::now();
+            for (size_t i = 0; i < image.size(); ++i) {
+                table[i] = quantizer.index(image[i]);
+            }
+            table_ms = std::min(table_ms, milliseconds_since(before));
+
+            before = Clock::now();
+            quantizer.indices(image.data(), image.size(), simd.data());
+            simd_ms = std::min(simd_ms, milliseconds_since(before));
+        }
+        const double mpx = double(image.size()) / 1e6;
+        std::printf("  %4u   %13.1f%%   %15.1f   %11.1f   %10.1f   (built in %.2f ms)%s\n",
+            colours, quantizer.coverage() * 100.0f, mpx / (reference_ms / 1e3), mpx / (table_ms / 1e3), mpx / (simd_ms / 1e3), build_ms,
+            (reference == table && reference == simd) ? "" : " MISMATCH");
+    }
+}
+
+//------------------------------------------------
+// palette: choosing n colours for a 1024x1024 image (soft gradients and blobs, a tenth transparent)
+//  with choose_palette, then mapping the image to them; reports throughput and the RMS error of the
+//  result, for median cut alone and with k-means refinement.
+
+static void bench_palette()
+{
+    const uint32_t width = 1024, height = 1024;
+    const uint32_t runs = 3;
+    std::vector<glm::u8vec4> image(width * height);
+    Random rng(0xc01005);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            float fx = float(x) / width, fy = float(y) / height;
+            float blob = std::max(0.0f, 1.0f - 8.0f * ((fx - 0.3f) * (fx - 0.3f) + (fy - 0.6f) * (fy - 0.6f)));
+            uint32_t noise = rng() & 0x7;
+            glm::u8vec4& p = image[x + width * y];
+            p = glm::u8vec4(uint8_t(200.0f * fx * (1.0f - blob) + 250.0f * blob) + noise,
+                uint8_t(180.0f * fy) + noise, uint8_t(120.0f * (1.0f - fx) + 60.0f * blob) + noise, 0xff);
+            if ((x / 32 + y / 32) % 10 == 0) {
+                p = glm::u8vec4(0, 0, 0, 0);
+            }
+        }
+    }
+    std::printf("palette: %ux%u image, best of %u\n", width, height, runs);
+    std::printf("  colours   k-means   choose Mpx/s   map Mpx/s   rms error\n");
+    for (uint32_t n : { 4U, 16U, 64U }) {
+        for (uint32_t iterations : { 0U, 4U }) {
+            double choose_ms = 1e30, map_ms = 1e30;
+            std::vector<glm::u8vec4> palette;
+            std::vector<uint8_t> indices(image.size());
+            for (uint32_t run = 0; run < runs; ++run) {
+                auto before = Clock::now();
+                palette = choose_palette(image.data(), image.size(), n, iterations);
+                choose_ms = std::min(choose_ms, milliseconds_since(before));
+                before = Clock::now();
+                Quantizer(palette, false).indices(image.data(), image.size(), indices.data());
+                map_ms = std::min(map_ms, milliseconds_since(before));
+            }
+            double error = 0.0;
+            for (size_t i = 0; i < image.size(); ++i) {
+                glm::vec4 d = glm::vec4(image[i]) - glm::vec4(palette[indices[i]]);
+                error += double(glm::dot(d, d));
+            }
+            const double mpx = double(image.size()) / 1e6;
+            std::printf("  %7u   %7u   %12.1f   %9.1f   %9.2f\n", n, iterations,
+                mpx / (choose_ms / 1e3), mpx / (map_ms / 1e3), std::sqrt(error / double(image.size())));
+        }
+    }
+}
+
+//------------------------------------------------
+// resample: scaling a 2048x2048 sprite sheet with Resampler (filter weights precomputed, output and
+//  scratch allocated once), against the old convert_to_new_size loop (integer factors only).
+
+static void bench_resample()
+{
+    const glm::uvec2 sheet(2048, 2048);
+    const uint32_t runs = 3;
+    std::vector<glm::u8vec4> image(size_t(sheet.x) * sheet.y);
+    Random rng(0x5ca1e);
+    for (uint32_t y = 0; y < sheet.y; ++y) {
+        for (uint32_t x = 0; x < sheet.x; ++x) {
+            uint32_t noise = rng();
+            image[x + sheet.x * y] = glm::u8vec4(x & 0xff, y & 0xff, (x ^ y) & 0xff, (noise & 0x3) ? 0xff : 0x00);
+        }
+    }
+    std::printf("resample: from %ux%u, best of %u (Mpx/s of source)\n", sheet.x, sheet.y, runs);
+
+    // (as convert_to_new_size + tile_avg used to do it)
+    auto old_resize = [&](glm::uvec2 to) {
+        std::vector<glm::u8vec4> new_data;
+        const size_t iter_x = sheet.x / to.x, iter_y = sheet.y / to.y;
+        for (size_t arr_y = 0; arr_y < to.y; arr_y++) {
+            for (size_t arr_x = 0; arr_x < to.x; arr_x++) {
+                int r = 0, g = 0, b = 0, a = 0;
+                for (size_t j = 0; j < iter_y; j++) {
+                    for (size_t i = 0; i < iter_x; i++) {
+                        glm::u8vec4 const& c = image[((arr_x * iter_x) + i) + sheet.x * ((arr_y * iter_y) + j)];
+                        r += c.r;
+                        g += c.g;
+                        b += c.b;
+                        a += c.a;
+                    }
+                }
+                const size_t count = iter_x * iter_y;
+                new_data.push_back(glm::u8vec4(r / count, g / count, b / count, a / count));
+            }
+        }
+        return new_data;
+    };
+
+    const double mpx = double(image.size()) / 1e6;
+    for (glm::uvec2 to : { glm::uvec2(512, 512), glm::uvec2(128, 128), glm::uvec2(1365, 1365), glm::uvec2(4096, 4096) }) {
+        std::printf("  to %4ux%-4u", to.x, to.y);
+        if (sheet.x % to.x == 0 && sheet.y % to.y == 0) {
+            double old_ms = 1e30;
+            std::vector<glm::u8vec4> old_out;
+            for (uint32_t run = 0; run < runs; ++run) {
+                auto before = Clock::now();
+                old_out = old_resize(to);
+                old_ms = std::min(old_ms, milliseconds_since(before));
+            }
+            std::printf("   old %7.1f", mpx / (old_ms / 1e3));
+        } else {
+            std::printf("   old     n/a");
+        }
+        for (Resampler::Filter filter : { Resampler::Nearest, Resampler::Box, Resampler::Lanczos3 }) {
+            Resampler resampler(sheet, to, filter);
+            std::vector<float> scratch(resampler.scratch_floats());
+            std::vector<glm::u8vec4> out(size_t(to.x) * to.y);
+            double ms = 1e30;
+            for (uint32_t run = 0; run < runs; ++run) {
+                auto before = Clock::now();
+                resampler.resample(image.data(), out.data(), scratch.data());
+                ms = std::min(ms, milliseconds_since(before));
+            }
+            static char const* names[] = { "nearest", "box", "lanczos3" };
+            std::printf("   %s %7.1f", names[filter], mpx / (ms / 1e3));
+        }
+        std::printf("\n");
+    }
+}
+
+//------------------------------------------------
+// tilemap: decoding a compressed 1024x1024 world map (open sky, ground and platforms, walls, some
+//  noisy decoration) with TilemapDecoder, in one go and a few rows at a time, against a plain memcpy
+//  of the same entries uncompressed; reports the compression and GB/s of entries written.
+
+static void bench_tilemap()
+{
+    const uint32_t width = 1024, height = 1024;
+    const uint32_t runs = 20;
+    std::vector<uint16_t> world(size_t(width) * height);
+    Random rng(0x71e5);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            uint16_t entry = (1 << 8) | 0; // sky
+            if (y % 64 < 8) {
+                entry = (2 << 8) | 1; // ground
+            } else if (y % 16 == 0 && (x / 48) % 3 == 1) {
+                entry = (2 << 8) | 2; // platform
+            } else if (x % 128 < 4) {
+                entry = (3 << 8) | uint16_t(4 + x % 4); // wall
+            }
+            if (rng() % 64 == 0) {
+                entry = uint16_t((rng() % 8) << 8 | (rng() % 256)); // decoration
+            }
+            world[x + width * y] = entry;
+        }
+    }
+    Tilemap tilemap = Tilemap::encode(width, height, world.data());
+    const double bytes = double(world.size()) * sizeof(uint16_t);
+    std::printf("tilemap: %ux%u, %.0f KiB encoded to %.0f KiB (%.1f%%), best of %u (GB/s of entries)\n", width, height,
+        bytes / 1024.0, tilemap.encoded.size() * 2 / 1024.0, 100.0 * tilemap.encoded.size() * 2 / bytes, runs);
+
+    std::vector<uint16_t> out(world.size());
+    auto time = [&](char const* name, std::function<void()> const& fn) {
+        double ms = 1e30;
+        for (uint32_t run = 0; run < runs; ++run) {
+            auto before = Clock::now();
+            fn();
+            ms = std::min(ms, milliseconds_since(before));
+        }
+        std::printf("  %-22s %6.2f\n", name, bytes / (ms / 1e3) / 1e9);
+    };
+    time("memcpy (uncompressed)", [&]() { std::memcpy(out.data(), world.data(), size_t(bytes)); });
+    time("decode", [&]() { tilemap.decode(out.data(), width); });
+    time("decode 16 rows a call", [&]() {
+        TilemapDecoder decoder(tilemap);
+        while (!decoder.done()) {
+            decoder.decode_rows(out.data(), width, 16);
+        }
+    });
+    if (out != world) {
+        std::printf("  (decoded map doesn't match!)\n");
+    }
+}
+
+//------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    std::vector<std::pair<std::string, std::function<void()>>> benchmarks = {
+        { "bullets", bench_bullets },
+        { "snapshot", bench_snapshot },
+        { "rewind", bench_rewind },
+        { "kinetic", bench_kinetic },
+        { "timers", bench_timers },
+        { "chunks", bench_chunks },
+        { "quantize", bench_quantize },
+        { "palette", bench_palette },
+        { "resample", bench_resample },
+        { "tilemap", bench_tilemap },
+    };
+
+    std::vector<std::string> names(argv + 1, argv + argc);
+    for (auto const& benchmark : benchmarks) {
+        if (names.empty() || std::find(names.begin(), names.end(), benchmark.first) != names.end()) {
+            benchmark.second();
+        }
+    }
+    for (std::string const& name : names) {
+        auto matches = [&name](auto const& benchmark) { return benchmark.first == name; };
+        if (std::find_if(benchmarks.begin(), benchmarks.end(), matches) == benchmarks.end()) {
+            std::cerr << "Unknown benchmark '" << name << "'." << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "GL.hpp"
-#include <iostream>
+#include "Log.hpp"
+
+#include <string>
 
 #define STR2(X) # X
 #define STR(X) STR2(X)
@@ -11,7 +13,7 @@ inline void gl_errors(std::string const &where) {
 	while ((err = glGetError()) != GL_NO_ERROR) {
 		#define CHECK( ERR ) \
 			if (err == ERR) { \
-				std::cerr << "WARNING: gl error '" #ERR "' at " << where << std::endl; \
+				LOG_WARN("gl error '" #ERR "' at " << where); \
 			} else
 
 		CHECK( GL_INVALID_ENUM )
@@ -22,7 +24,7 @@ inline void gl_errors(std::string const &where) {
 		CHECK( GL_STACK_UNDERFLOW )
 		CHECK( GL_STACK_OVERFLOW )
 		{
-			std::cerr << "WARNING: gl error '" << err << "'" << std::endl;
+			LOG_WARN("gl error '" << err << "' at " << where);
 		}
 		#undef CHECK
 	}
@@ -0,0 +1,369 @@
+// headless -- run many complete games of Redirekt without a window, as fast as possible.
+//
+// Usage:
+//   dist/headless [--games N] [--seed S] [--dt SECONDS] [--replay FILE] [--bot] [--pattern FILE] [--config FILE] [--kinetic] [--threads T] [--csv FILE] [--scaling]
+//
+// Input is either random (a new random set of Buttons held for a random number of ticks),
+//  scripted (the Buttons and timesteps from a replay, looped if the game outlasts it),
+//  or played by a Bot (which also reports how long its plans and the ticks between them take).
+// --config plays with balance values from a GameConfig file instead of the defaults (a replay's
+//  recorded config is used if there is one, and a different --config is refused; likewise --pattern).
+// --kinetic plays with the event-driven KineticGame instead (random or replayed input only).
+//
+// Game i is played with seed S+i. Games are independent, so they are spread over a
+//  ThreadPool with T workers (default: one per hardware thread); results are stored
+//  per seed, so they do not depend on how the games were scheduled.
+//
+// --scaling re-runs the same batch with 1, 2, 4, ... threads and reports the speedup.
+
+#include "Bot.hpp"
+#include "Game.hpp"
+#include "Kinetic.hpp"
+#include "Replay.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct GameResult {
+    uint32_t seed = 0;
+    int score = 0;
+    uint64_t ticks = 0;
+    uint32_t hits = 0; // (counted from the game's events)
+    uint32_t redirects = 0;
+    // Bot::next is timed on a sample of calls (reading the clock costs about as much as steering):
+    uint64_t plans = 0;
+    uint64_t sweeps = 0; // (projectiles those plans tried all four aim directions for)
+    uint64_t timed_plans = 0, timed_steers = 0; // sampled calls that planned / just steered
+    double plan_seconds = 0.0, steer_seconds = 0.0; // ...and the time they took (clock overhead removed)
+};
+
+struct Settings {
+    uint32_t games = 1000;
+    uint32_t seed = 0;
+    float dt = 1.0f / 60.0f;
+    Replay replay; // if not empty, input comes from here
+    bool bot = false; // if set, input comes from a Bot
+    Pattern pattern; // bullet pattern played in every game (may be empty)
+    GameConfig config;
+    bool kinetic = false; // if set, play KineticGame instead of Game
+};
+
+// play one complete KineticGame:
+static GameResult play_kinetic(Settings const& settings, uint32_t seed)
+{
+    GameResult result;
+    result.seed = seed;
+
+    KineticGame game(seed, 1, settings.config);
+    RandomInput random_input(seed);
+    Replay const& replay = settings.replay;
+    size_t replay_tick = 0;
+    while (!game.over()) {
+        float tick_dt = settings.dt;
+        if (replay.size()) {
+            game.set_buttons(replay.buttons[replay_tick]);
+            tick_dt = replay.elapsed[replay_tick];
+            replay_tick = (replay_tick + 1) % replay.size();
+        } else {
+            game.set_buttons(random_input.next());
+        }
+        game.update(tick_dt);
+        result.ticks++;
+    }
+    result.score = game.score;
+    result.hits = game.hits;
+    result.redirects = game.redirects;
+    return result;
+}
+
+// Bot::next is timed on one call in this many:
+static const uint64_t BotSampling = 8;
+
+// what timing an empty stretch of code with steady_clock reads as (measured once):
+static double clock_overhead()
+{
+    // (the quietest of several batches, so a context switch during calibration doesn't count)
+    static const double overhead = []() {
+        double best = 1.0;
+        for (uint32_t batch = 0; batch < 100; ++batch) {
+            const uint32_t samples = 1000;
+            double total = 0.0;
+            for (uint32_t i = 0; i < samples; ++i) {
+                auto before = std::chrono::steady_clock::now();
+                total += std::chrono::duration<double>(std::chrono::steady_clock::now() - before).count();
+            }
+            best = std::min(best, total / samples);
+        }
+        return best;
+    }();
+    return overhead;
+}
+
+// play one complete game:
+static GameResult play(Settings const& settings, uint32_t seed)
+{
+    GameResult result;
+    result.seed = seed;
+
+    Game game(seed, 1, settings.config);
+    game.pattern = &settings.pattern;
+    RandomInput random_input(seed);
+    Bot bot;
+    Replay const& replay = settings.replay;
+    size_t replay_tick = 0;
+    while (!game.over()) {
+        float tick_dt = settings.dt;
+        if (replay.size()) {
+            game.set_buttons(replay.buttons[replay_tick]);
+            tick_dt = replay.elapsed[replay_tick];
+            replay_tick = (replay_tick + 1) % replay.size();
+        } else if (settings.bot) {
+            uint8_t buttons;
+            if (result.ticks % BotSampling == 0) {
+                const uint64_t plans = bot.plans;
+                auto before = std::chrono::steady_clock::now();
+                buttons = bot.next(game);
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - before).count() - clock_overhead();
+                if (bot.plans != plans) {
+                    result.timed_plans++;
+                    result.plan_seconds += seconds;
+                } else {
+                    result.timed_steers++;
+                    result.steer_seconds += seconds;
+                }
+            } else {
+                buttons = bot.next(game);
+            }
+            game.set_buttons(buttons);
+        } else {
+            game.set_buttons(random_input.next());
+        }
+        game.update(tick_dt);
+        result.ticks++;
+        for (uint32_t e = 0; e < game.event_count; ++e) {
+            GameEvent const& event = game.events[e];
+            result.hits += (event.type == GameEvent::Hit);
+            result.redirects += (event.type == GameEvent::Redirect);
+        }
+    }
+    result.score = game.score;
+    result.plans = bot.plans;
+    result.sweeps = bot.sweeps;
+    return result;
+}
+
+// play all the games on 'threads' threads, returns wall-clock seconds taken:
+static double play_all(Settings const& settings, uint32_t threads, std::vector<GameResult>* results_)
+{
+    std::vector<GameResult>& results = *results_;
+    results.assign(settings.games, GameResult());
+
+    ThreadPool pool(threads);
+    auto before = std::chrono::high_resolution_clock::now();
+    pool.parallel_for(settings.games, [&](size_t i) {
+        const uint32_t seed = settings.seed + uint32_t(i);
+        results[i] = (settings.kinetic ? play_kinetic(settings, seed) : play(settings, seed));
+    });
+    auto after = std::chrono::high_resolution_clock::now();
+    return std::max(1e-9, std::chrono::duration<double>(after - before).count());
+}
+
+static uint64_t total_ticks(std::vector<GameResult> const& results)
+{
+    uint64_t ticks = 0;
+    for (GameResult const& r : results) {
+        ticks += r.ticks;
+    }
+    return ticks;
+}
+
+int main(int argc, char** argv)
+{
+    Settings settings;
+    uint32_t threads = 0;
+    bool scaling = false;
+    std::string csv_file;
+    bool config_given = false;
+    bool pattern_given = false;
+    auto usage = [&]() {
+        std::cerr << "Usage:\n\t" << argv[0] << " [--games N] [--seed S] [--dt SECONDS] [--replay FILE] [--bot] [--pattern FILE] [--config FILE] [--kinetic] [--threads T] [--csv FILE] [--scaling]" << std::endl;
+        return 1;
+    };
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--games" && i + 1 < argc) {
+            settings.games = uint32_t(std::stoul(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            settings.seed = uint32_t(std::stoul(argv[++i]));
+        } else if (arg == "--dt" && i + 1 < argc) {
+            settings.dt = std::stof(argv[++i]);
+            if (!(settings.dt > 0.0f)) {
+                std::cerr << "--dt must be more than zero (or the games never end)." << std::endl;
+                return usage();
+            }
+        } else if (arg == "--replay" && i + 1 < argc) {
+            settings.replay = Replay::load(argv[++i]);
+        } else if (arg == "--bot") {
+            settings.bot = true;
+        } else if (arg == "--pattern" && i + 1 < argc) {
+            settings.pattern = Pattern::load(argv[++i]);
+            pattern_given = true;
+        } else if (arg == "--config" && i + 1 < argc) {
+            settings.config = GameConfig::load(argv[++i]);
+            config_given = true;
+        } else if (arg == "--kinetic") {
+            settings.kinetic = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = uint32_t(std::stoul(argv[++i]));
+        } else if (arg == "--csv" && i + 1 < argc) {
+            csv_file = argv[++i];
+        } else if (arg == "--scaling") {
+            scaling = true;
+        } else {
+            return usage();
+        }
+    }
+    // (replayed input only makes sense with the balance values it was recorded with)
+    if (settings.replay.size() && settings.replay.has_config) {
+        if (config_given && settings.config != settings.replay.config) {
+            std::cerr << "The replay was recorded with a different game config than --config gives; leave --config out to use the recorded one." << std::endl;
+            return 1;
+        }
+        settings.config = settings.replay.config;
+    }
+    // (...and the bullets)
+    if (settings.replay.size() && settings.replay.has_pattern) {
+        if (pattern_given && settings.pattern != settings.replay.pattern) {
+            std::cerr << "The replay was recorded with a different bullet pattern than --pattern gives; leave --pattern out to use the recorded one." << std::endl;
+            return 1;
+        }
+        settings.pattern = settings.replay.pattern;
+    }
+    if (settings.kinetic && (settings.bot || !settings.pattern.emitters.empty())) {
+        std::cerr << "--kinetic doesn't support --bot or --pattern." << std::endl;
+        return 1;
+    }
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    std::vector<GameResult> results;
+    double seconds = play_all(settings, threads, &results);
+    uint64_t ticks = total_ticks(results);
+
+    double mean = 0.0;
+    for (GameResult const& r : results) {
+        mean += r.score;
+    }
+    mean /= std::max<size_t>(1, results.size());
+    double variance = 0.0;
+    for (GameResult const& r : results) {
+        variance += (r.score - mean) * (r.score - mean);
+    }
+    variance /= std::max<size_t>(1, results.size());
+
+    std::cout << "Ran " << settings.games << " games (" << ticks << " ticks) on " << threads << " threads in " << seconds << "s." << std::endl;
+    std::cout << "  games/sec: " << settings.games / seconds << std::endl;
+    std::cout << "  ticks/sec: " << ticks / seconds << std::endl;
+    if (!results.empty()) {
+        auto by_score = [](GameResult const& a, GameResult const& b) { return a.score < b.score; };
+        std::cout << "  score: mean " << mean << ", stddev " << std::sqrt(variance)
+                  << ", min " << std::min_element(results.begin(), results.end(), by_score)->score
+                  << ", max " << std::max_element(results.begin(), results.end(), by_score)->score << std::endl;
+        uint64_t hits = 0, redirects = 0;
+        for (GameResult const& r : results) {
+            hits += r.hits;
+            redirects += r.redirects;
+        }
+        std::cout << "  per game: " << double(hits) / results.size() << " hits, "
+                  << double(redirects) / results.size() << " redirects" << std::endl;
+
+        // score distribution:
+        std::vector<int> scores;
+        for (GameResult const& r : results) {
+            scores.emplace_back(r.score);
+        }
+        std::sort(scores.begin(), scores.end());
+        auto percentile = [&](double p) { return scores[std::min(scores.size() - 1, size_t(p * scores.size()))]; };
+        std::cout << "  score percentiles: 10% " << percentile(0.1) << ", 25% " << percentile(0.25) << ", 50% " << percentile(0.5)
+                  << ", 75% " << percentile(0.75) << ", 90% " << percentile(0.9) << std::endl;
+        const int buckets = 10;
+        const int width = std::max(1, (scores.back() - scores.front() + buckets) / buckets);
+        std::vector<size_t> histogram(buckets, 0);
+        for (int score : scores) {
+            histogram[std::min(buckets - 1, (score - scores.front()) / width)]++;
+        }
+        size_t tallest = *std::max_element(histogram.begin(), histogram.end());
+        for (int b = 0; b < buckets; ++b) {
+            int low = scores.front() + b * width;
+            std::printf("    %4d-%-4d %6zu %s\n", low, low + width - 1, histogram[b], std::string(40 * histogram[b] / tallest, '#').c_str());
+        }
+
+        if (settings.bot) {
+            uint64_t plans = 0, sweeps = 0, timed_plans = 0, timed_steers = 0;
+            double plan_seconds = 0.0, steer_seconds = 0.0;
+            for (GameResult const& r : results) {
+                plans += r.plans;
+                sweeps += r.sweeps;
+                timed_plans += r.timed_plans;
+                timed_steers += r.timed_steers;
+                plan_seconds += r.plan_seconds;
+                steer_seconds += r.steer_seconds;
+            }
+            // (clamped, since subtracting the clock overhead can leave a little less than nothing)
+            const double per_plan = std::max(0.0, plan_seconds / std::max<uint64_t>(1, timed_plans));
+            const double per_steer = std::max(0.0, steer_seconds / std::max<uint64_t>(1, timed_steers));
+            const double total = per_plan * plans + per_steer * (ticks - plans);
+            std::cout << "  bot: " << 1e9 * per_plan << " ns per plan (" << double(plans) / results.size() << " per game, "
+                      << double(sweeps) / std::max<uint64_t>(1, plans) << " projectiles swept per plan), "
+                      << 1e9 * per_steer << " ns per tick in between; " << 1e9 * total / ticks << " ns per tick overall ("
+                      << 100.0 * total / (seconds * threads) << "% of the run; timed on 1 in " << BotSampling << " ticks, less "
+                      << 1e9 * clock_overhead() << " ns of clock overhead)" << std::endl;
+        }
+    }
+
+    if (!csv_file.empty()) {
+        std::ofstream csv(csv_file);
+        csv << "seed,score,ticks,hits,redirects\n";
+        for (GameResult const& r : results) {
+            csv << r.seed << ',' << r.score << ',' << r.ticks << ',' << r.hits << ',' << r.redirects << '\n';
+        }
+        std::cout << "Wrote per-seed results to '" << csv_file << "'." << std::endl;
+    }
+
+    if (scaling) {
+        std::vector<uint32_t> counts;
+        for (uint32_t t = 1; t < threads; t *= 2) {
+            counts.emplace_back(t);
+        }
+        counts.emplace_back(threads);
+
+        std::cout << "Scaling report (" << settings.games << " games):\n";
+        std::cout << "  threads   games/sec   ticks/sec   speedup   efficiency\n";
+        double base = 0.0;
+        for (uint32_t t : counts) {
+            std::vector<GameResult> check;
+            double s = play_all(settings, t, &check);
+            double games_per_second = settings.games / s;
+            if (t == counts[0]) {
+                base = games_per_second;
+            }
+            bool same = true;
+            for (size_t i = 0; i < check.size(); ++i) {
+                same = same && check[i].score == results[i].score && check[i].ticks == results[i].ticks;
+            }
+            std::printf("  %7u  %10.1f  %10.0f  %7.2fx  %10.1f%%%s\n",
+                t, games_per_second, total_ticks(check) / s, games_per_second / base,
+                100.0 * games_per_second / base / t, same ? "" : "  (RESULTS DIFFER!)");
+        }
+    }
+
+    return 0;
+}
@@ -1,5 +1,9 @@
 #include "load_save_png.hpp"
 
+#include "Log.hpp"
+#include "Quantizer.hpp"
+#include "Resampler.hpp"
+
 #include <png.h>
 
 #include <cassert>
@@ -7,9 +11,6 @@
 #include <iostream>
 #include <vector>
 
-#define LOG_ERROR(X) std::cerr << X << std::endl
-#define COLOR_TO_VEC4(c) (glm::vec4(c.r, c.g, c.b, c.a))
-
 using std::vector;
 
 bool load_png(std::istream& from, unsigned int* width, unsigned int* height, vector<glm::u8vec4>* data, OriginLocation origin);
@@ -182,95 +183,39 @@ void save_png(std::ostream& to, unsigned int width, unsigned int height, glm::u8
     return;
 }
 
-glm::u8vec4 tile_avg(const std::vector<glm::u8vec4>& data, const glm::uvec2 size, const size_t x, const size_t y, const size_t w, const size_t h)
-{
-    // take the average of colours into one
-    int r, g, b, a;
-    r = g = b = a = 0;
-    for (size_t j = 0; j < h; j++) {
-        for (size_t i = 0; i < w; i++) {
-            const glm::u8vec4& og_colour = data[((x * w) + i) + size.x * ((y * h) + j)];
-            r += (int)(og_colour.r);
-            g += (int)(og_colour.g);
-            b += (int)(og_colour.b);
-            a += (int)(og_colour.a);
-        }
-    }
-    const size_t count = w * h;
-    return glm::u8vec4(r / count, g / count, b / count, a / count);
-}
-
-glm::u8vec4 closest_in_bank(const glm::u8vec4& og_colour, const std::vector<glm::u8vec4>& colour_bank)
-{
-    // compute (euclidean) distance to the representative n colours and use the best colour (smallest dist)
-    // to represent this pixel
-    glm::u8vec4 new_colour = colour_bank[0];
-    float best_dist = 1e9; // +inf
-    for (const glm::u8vec4& nth_colour : colour_bank) {
-        const float dist = glm::length(COLOR_TO_VEC4(nth_colour) - COLOR_TO_VEC4(og_colour));
-        if (dist < best_dist) {
-            best_dist = dist;
-            new_colour = nth_colour;
-        }
-    }
-    return new_colour;
-}
-
 void convert_to_n_colours(const size_t n, const glm::uvec2 size, glm::u8vec4* data, std::vector<glm::u8vec4>& bank)
 {
     // convert the spectrum of colours from 0-255 to 0-n respecting the distribution
-    // first determine which n colours are to be used
-
-    bank = {
-        glm::u8vec4(0, 0, 0, 0),
-        glm::u8vec4(255, 0, 0, 255),
-        glm::u8vec4(200, 200, 0, 255),
-        glm::u8vec4(0, 0, 255, 255),
-    };
-
-    // then determine how these colours map to the data
-    for (size_t y = 0; y < size.y; y++) {
-        for (size_t x = 0; x < size.x; x++) {
-            data[x + size.x * y] = closest_in_bank(data[x + size.x * y], bank);
-        }
+    // first determine which n colours are to be used (median cut + k-means, see Quantizer.hpp)
+    const size_t count = size_t(size.x) * size.y;
+    bank = choose_palette(data, count, uint32_t(n));
+
+    // then determine how these colours map to the data (closest colour in the bank, see Quantizer.hpp)
+    //  (fully transparent pixels all go to the transparent slot, and the rest only to opaque colours)
+    const bool transparent_slot = (bank[0] == glm::u8vec4(0, 0, 0, 0));
+    const size_t first = (transparent_slot && bank.size() > 1) ? 1 : 0;
+    std::vector<uint8_t> indices(count);
+    Quantizer(std::vector<glm::u8vec4>(bank.begin() + first, bank.end()), false).indices(data, count, indices.data());
+    for (size_t i = 0; i < count; i++) {
+        data[i] = (transparent_slot && data[i].a == 0) ? bank[0] : bank[first + indices[i]];
     }
 }
 
 void convert_to_new_size(const glm::uvec2 new_size, glm::uvec2& size, std::vector<glm::u8vec4>& data)
 {
-    // downsample the image from size.x x size.y to (new_size.x x new_size.y)
-    /// NOTE: only supports downsampling currently (not upsampling!)
-    std::vector<glm::u8vec4> new_data;
-    const size_t iter_x = size.x / new_size.x;
-    const size_t iter_y = size.y / new_size.y;
-    /// TODO: check this is the best (loop traversal) order for cache locality
-    for (size_t arr_y = 0; arr_y < new_size.y; arr_y++) {
-        for (size_t arr_x = 0; arr_x < new_size.x; arr_x++) {
-            new_data.push_back(tile_avg(data, size, arr_x, arr_y, iter_x, iter_y));
-        }
-    }
-    data.clear();
+    // resample the image from size.x x size.y to (new_size.x x new_size.y), averaging (box filter) when shrinking
+    Resampler resampler(size, new_size, Resampler::Box);
+    std::vector<float> scratch(resampler.scratch_floats());
+    std::vector<glm::u8vec4> new_data(size_t(new_size.x) * new_size.y);
+    resampler.resample(data.data(), new_data.data(), scratch.data());
     // update the original data with the new data
-    data = new_data;
+    data = std::move(new_data);
     size = new_size;
 }
 
 void convert_to_new_size_with_bank(const glm::uvec2 new_size, glm::uvec2& size, std::vector<glm::u8vec4>& data, const std::vector<glm::u8vec4>& colour_bank)
 {
-    // downsample the image from size.x x size.y to (new_size.x x new_size.y)
-    /// NOTE: only supports downsampling currently (not upsampling!)
-    std::vector<glm::u8vec4> new_data;
-    const size_t iter_x = size.x / new_size.x;
-    const size_t iter_y = size.y / new_size.y;
-    /// TODO: check this is the best (loop traversal) order for cache locality
-    for (size_t arr_y = 0; arr_y < new_size.y; arr_y++) {
-        for (size_t arr_x = 0; arr_x < new_size.x; arr_x++) {
-            glm::u8vec4 avg = tile_avg(data, size, arr_x, arr_y, iter_x, iter_y);
-            new_data.push_back(closest_in_bank(avg, colour_bank));
-        }
-    }
-    data.clear();
-    // update the original data with the new data
-    data = new_data;
-    size = new_size;
-}
\ No newline at end of file
+    convert_to_new_size(new_size, size, data);
+    // then snap every averaged pixel to the closest colour in the bank:
+    Quantizer(colour_bank, false).quantize(data.data(), data.size());
+}
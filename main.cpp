@@ -13,6 +13,18 @@
 //for screenshots:
 #include "load_save_png.hpp"
 
+//for recording and replaying input:
+#include "Replay.hpp"
+
+//for letting a bot play:
+#include "Bot.hpp"
+
+//for sending log messages to a file:
+#include "Log.hpp"
+
+//for finding the sprite list to hot reload:
+#include "data_path.hpp"
+
 //Includes for libSDL:
 #include <SDL.h>
 
@@ -22,6 +34,8 @@
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
+#include <random>
+#include <string>
 
 #ifdef _WIN32
 extern "C" { uint32_t GetACP(); }
@@ -42,6 +56,86 @@ int main(int argc, char **argv) {
 	try {
 #endif
 
+	//------------  command line ------------
+
+	//--record <file> saves this game's input as a replay on exit
+	//--replay <file> plays back a replay instead of reading the keyboard
+	//--fast plays back the replay as fast as possible instead of in real time
+	//--pattern <file> adds the bullets from a bullet pattern file (see Bullets.hpp; recorded in replays like --config)
+	//--bot lets a Bot play instead of the keyboard
+	//--config <file> plays with balance values from a GameConfig file (recorded in replays; --replay uses the recorded one, and refuses a different --config)
+	//--log <file> appends log messages to a file instead of stderr
+	//--hot-reload converts sprites again when assets/sprites.txt or their pngs are saved (see HotReload.hpp)
+	std::string record_file;
+	std::string replay_file;
+	std::string pattern_file;
+	GameConfig config;
+	bool config_given = false;
+	bool use_bot = false;
+	bool fast = false;
+	bool hot_reload = false;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--record" && i + 1 < argc) {
+			record_file = argv[++i];
+		} else if (arg == "--replay" && i + 1 < argc) {
+			replay_file = argv[++i];
+		} else if (arg == "--fast") {
+			fast = true;
+		} else if (arg == "--pattern" && i + 1 < argc) {
+			pattern_file = argv[++i];
+		} else if (arg == "--bot") {
+			use_bot = true;
+		} else if (arg == "--config" && i + 1 < argc) {
+			config = GameConfig::load(argv[++i]);
+			config_given = true;
+		} else if (arg == "--log" && i + 1 < argc) {
+			Log::set_output(argv[++i]);
+		} else if (arg == "--hot-reload") {
+			hot_reload = true;
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--record <file>] [--replay <file> [--fast]] [--pattern <file>] [--bot] [--config <file>] [--log <file>] [--hot-reload]" << std::endl;
+			return 1;
+		}
+	}
+
+	Pattern pattern;
+	if (!pattern_file.empty()) {
+		pattern = Pattern::load(pattern_file);
+	}
+
+	Replay replay;
+	if (!replay_file.empty()) {
+		replay = Replay::load(replay_file);
+		std::cout << "Replaying " << replay.size() << " ticks from '" << replay_file << "'." << std::endl;
+		//the replay only plays back the same game with the same balance values:
+		if (replay.has_config) {
+			if (config_given && config != replay.config) {
+				std::cerr << "Replay '" << replay_file << "' was recorded with a different game config than --config gives; leave --config out to use the recorded one." << std::endl;
+				return 1;
+			}
+			config = replay.config;
+		} else {
+			std::cout << "WARNING: replay '" << replay_file << "' has no recorded game config; playing it with " << (config_given ? "--config" : "the defaults") << "." << std::endl;
+		}
+		//...and the same bullets:
+		if (replay.has_pattern) {
+			if (!pattern_file.empty() && pattern != replay.pattern) {
+				std::cerr << "Replay '" << replay_file << "' was recorded with a different bullet pattern than --pattern gives; leave --pattern out to use the recorded one." << std::endl;
+				return 1;
+			}
+			pattern = replay.pattern;
+		} else {
+			std::cout << "WARNING: replay '" << replay_file << "' has no recorded bullet pattern; playing it with " << (pattern_file.empty() ? "none" : "--pattern") << "." << std::endl;
+		}
+	} else {
+		replay.seed = std::random_device()();
+	}
+	Replay recording;
+	recording.seed = replay.seed;
+	recording.config = config;
+	recording.pattern = pattern;
+
 	//------------  initialization ------------
 
 	//Initialize SDL library:
@@ -92,7 +186,10 @@ int main(int argc, char **argv) {
 	init_GL();
 
 	//Set VSYNC + Late Swap (prevents crazy FPS):
-	if (SDL_GL_SetSwapInterval(-1) != 0) {
+	if (fast && !replay_file.empty()) {
+		//...unless crazy FPS is exactly what was asked for:
+		SDL_GL_SetSwapInterval(0);
+	} else if (SDL_GL_SetSwapInterval(-1) != 0) {
 		std::cerr << "NOTE: couldn't set vsync + late swap tearing (" << SDL_GetError() << ")." << std::endl;
 		if (SDL_GL_SetSwapInterval(1) != 0) {
 			std::cerr << "NOTE: couldn't set vsync (" << SDL_GetError() << ")." << std::endl;
@@ -106,7 +203,18 @@ int main(int argc, char **argv) {
 	call_load_functions();
 
 	//------------ create game mode + make current --------------
-	Mode::set_current(std::make_shared< PlayMode >());
+	//(keep a reference to the PlayMode so the replay survives the mode ending)
+	std::shared_ptr< PlayMode > play = std::make_shared< PlayMode >(replay.seed, config);
+	if (!replay_file.empty()) play->replay_from = &replay;
+	if (!record_file.empty()) play->record_to = &recording;
+	if (!pattern.emitters.empty()) play->game.pattern = &pattern;
+	Bot bot;
+	if (use_bot) play->bot = &bot;
+	//(the sprite list and pngs live in the source tree, one level up from dist/)
+	if (hot_reload) play->hot_reload = std::make_unique< SpriteHotReload >(data_path("../assets/sprites.txt"), data_path(".."));
+	Mode::set_current(play);
+
+	auto replay_start = std::chrono::high_resolution_clock::now();
 
 	//------------ main loop ------------
 
@@ -186,6 +294,18 @@ int main(int argc, char **argv) {
 	}
 
 
+	//------------  replay bookkeeping ------------
+
+	if (!replay_file.empty()) {
+		float seconds = std::chrono::duration< float >(std::chrono::high_resolution_clock::now() - replay_start).count();
+		std::cout << "Replayed " << play->replay_tick << " ticks in " << seconds << "s ("
+			<< play->replay_tick / std::max(seconds, 1e-6f) << " ticks/s), final score " << play->game.score << "." << std::endl;
+	}
+	if (!record_file.empty()) {
+		recording.save(record_file);
+		std::cout << "Recorded " << recording.size() << " ticks to '" << record_file << "'." << std::endl;
+	}
+
 	//------------  teardown ------------
 
 	SDL_GL_DeleteContext(context);
@@ -194,6 +314,10 @@ int main(int argc, char **argv) {
 	SDL_DestroyWindow(window);
 	window = NULL;
 
+	if (Log::dropped()) {
+		std::cerr << "NOTE: " << Log::dropped() << " log messages were dropped." << std::endl;
+	}
+
 	return 0;
 
 #ifdef _WIN32
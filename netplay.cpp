@@ -0,0 +1,141 @@
+// netplay -- two-player rollback games over a simulated network, to tune input delay.
+//
+// Usage:
+//   dist/netplay [--games N] [--seed S] [--latency MS] [--jitter MS] [--loss FRACTION] [--delay TICKS]
+//
+// Plays N complete two-player games (seeds S, S+1, ...) between two Rollback peers connected by a
+// LoopbackLink, with random input on both sides, once for every input delay from 0 to 8 ticks
+// (or just --delay). Reports rollback frequency and cost for each delay, and checks that both
+// peers ended up with exactly the same game.
+
+#include "Bot.hpp"
+#include "Game.hpp"
+#include "Rollback.hpp"
+#include "Transport.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct Totals {
+    Rollback::Stats stats; // (summed over both peers of every game)
+    uint64_t frames = 0; // frames run by each peer
+    uint32_t desyncs = 0;
+    float rtt = 0.0f;
+    uint32_t suggested_delay = 0;
+};
+
+// fields that must match on both peers once every input is confirmed:
+static bool same_game(GameState const& a, GameState const& b)
+{
+    if (a.rng.state != b.rng.state || a.score != b.score || a.time_left != b.time_left || a.scores != b.scores) {
+        return false;
+    }
+    for (uint32_t p = 0; p < GameState::MaxPlayers; ++p) {
+        if (a.siphons[p].pos != b.siphons[p].pos || a.siphons[p].aimDirection != b.siphons[p].aimDirection) {
+            return false;
+        }
+    }
+    if (a.projectiles.count != b.projectiles.count || a.bullets.count != b.bullets.count) {
+        return false;
+    }
+    for (uint32_t i = 0; i < a.projectiles.count; ++i) {
+        if (a.projectiles.items[i].pos != b.projectiles.items[i].pos) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void play(uint32_t seed, LoopbackLink::Settings const& link_settings, uint32_t delay, Totals* totals)
+{
+    const float dt = 1.0f / 60.0f;
+    LoopbackLink link(link_settings, seed);
+    Game game_a(seed, 2), game_b(seed, 2);
+    Rollback a(&game_a, 0, &link.a(), delay, dt);
+    Rollback b(&game_b, 1, &link.b(), delay, dt);
+    RandomInput input_a(seed, 3), input_b(seed, 4);
+
+    // play until both sides are past the end of the game and have all of each other's input:
+    const uint32_t end = uint32_t(std::ceil(game_a.time_left / dt)) + 1;
+    uint64_t frames = 0;
+    while (a.now() < end || b.now() < end || a.confirmed() < end || b.confirmed() < end) {
+        link.advance(dt);
+        for (auto [peer, input] : { std::make_pair(&a, &input_a), std::make_pair(&b, &input_b) }) {
+            if (peer->now() < end) {
+                peer->tick(input->next());
+            } else {
+                peer->poll();
+            }
+        }
+        frames++;
+    }
+
+    totals->frames += frames;
+    totals->desyncs += !same_game(game_a.state(), game_b.state());
+    totals->rtt += a.stats.rtt + b.stats.rtt;
+    totals->suggested_delay = std::max({ totals->suggested_delay, a.suggested_delay(), b.suggested_delay() });
+    for (Rollback const* peer : { &a, &b }) {
+        Rollback::Stats& t = totals->stats;
+        t.ticks += peer->stats.ticks;
+        t.stalls += peer->stats.stalls;
+        t.rollbacks += peer->stats.rollbacks;
+        t.resimulated += peer->stats.resimulated;
+        t.max_resimulated = std::max(t.max_resimulated, peer->stats.max_resimulated);
+        t.resimulate_seconds += peer->stats.resimulate_seconds;
+        t.packets_sent += peer->stats.packets_sent;
+        t.packets_received += peer->stats.packets_received;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t games = 20;
+    uint32_t seed = 0;
+    LoopbackLink::Settings link;
+    link.latency = 0.05f;
+    link.jitter = 0.01f;
+    link.loss = 0.02f;
+    std::vector<uint32_t> delays = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--games" && i + 1 < argc) {
+            games = uint32_t(std::stoul(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = uint32_t(std::stoul(argv[++i]));
+        } else if (arg == "--latency" && i + 1 < argc) {
+            link.latency = std::stof(argv[++i]) / 1000.0f;
+        } else if (arg == "--jitter" && i + 1 < argc) {
+            link.jitter = std::stof(argv[++i]) / 1000.0f;
+        } else if (arg == "--loss" && i + 1 < argc) {
+            link.loss = std::stof(argv[++i]);
+        } else if (arg == "--delay" && i + 1 < argc) {
+            delays = { uint32_t(std::stoul(argv[++i])) };
+        } else {
+            std::cerr << "Usage:\n\t" << argv[0] << " [--games N] [--seed S] [--latency MS] [--jitter MS] [--loss FRACTION] [--delay TICKS]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::printf("%u two-player games per delay; latency %.0f ms, jitter %.0f ms, loss %.1f%%\n",
+        games, link.latency * 1000.0f, link.jitter * 1000.0f, link.loss * 100.0f);
+    std::printf("  delay   rollbacks/100 ticks   resim ticks/frame (max)   resim ms/frame   stalls/game   desyncs\n");
+    uint32_t suggested = 0;
+    for (uint32_t delay : delays) {
+        Totals totals;
+        for (uint32_t g = 0; g < games; ++g) {
+            play(seed + g, link, delay, &totals);
+        }
+        Rollback::Stats const& s = totals.stats;
+        double peer_frames = 2.0 * double(totals.frames);
+        std::printf("  %5u   %19.2f   %15.2f (%5u)   %14.4f   %11.1f   %7u\n",
+            delay, 100.0 * s.rollbacks / std::max<uint64_t>(1, s.ticks), s.resimulated / peer_frames, s.max_resimulated,
+            1000.0 * s.resimulate_seconds / peer_frames, double(s.stalls) / (2.0 * games), totals.desyncs);
+        suggested = std::max(suggested, totals.suggested_delay);
+    }
+    std::printf("Suggested input delay from the measured round trip: %u ticks\n", suggested);
+    return 0;
+}
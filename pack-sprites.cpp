@@ -0,0 +1,74 @@
+// pack-sprites -- bake PNG sprites into PPU tiles and palettes, ahead of time.
+//
+// Usage:
+//   dist/pack-sprites [--cache DIR] [--prune] <list.txt> <out.sprites>
+//
+// Every line of the list names a sprite, the PNG it comes from, how many rotations to make, and
+// the four colours to match its pixels against, or 'auto' to pick them from the image with
+// convert_to_n_colours (see assets/sprites.txt, and SpriteList.hpp for the parsing and conversion).
+// Each PNG is downsampled to 8x8, colour-matched and turned into tiles exactly as PlayMode used to
+// do at startup; the result is written in the format Sprites reads (see Sprites.hpp).
+//
+// --cache DIR keeps every converted sprite in DIR (see SpriteCache.hpp), so later runs only decode
+// and convert sprites whose PNG or list entry changed; --prune then deletes cache entries this run
+// didn't use.
+
+#include "SpriteCache.hpp"
+#include "SpriteList.hpp"
+#include "Sprites.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    std::string cache_dir;
+    bool prune = false;
+    std::vector<std::string> files;
+    for (int argi = 1; argi < argc; ++argi) {
+        std::string arg = argv[argi];
+        if (arg == "--cache" && argi + 1 < argc) {
+            cache_dir = argv[++argi];
+        } else if (arg == "--prune") {
+            prune = true;
+        } else {
+            files.emplace_back(arg);
+        }
+    }
+    if (files.size() != 2 || (prune && cache_dir.empty())) {
+        std::cerr << "Usage:\n\t" << argv[0] << " [--cache DIR] [--prune] <list.txt> <out.sprites>" << std::endl;
+        return 1;
+    }
+    std::string const& list_file = files[0];
+    std::string const& out_file = files[1];
+    try {
+        auto before = std::chrono::high_resolution_clock::now();
+        SpriteList list(list_file);
+        std::unique_ptr<SpriteCache> cache;
+        if (!cache_dir.empty()) {
+            cache = std::make_unique<SpriteCache>(cache_dir);
+        }
+
+        Sprites sprites = list.pack(cache.get());
+
+        sprites.save(out_file);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - before).count();
+        std::cout << "Packed " << sprites.sprites.size() << " sprites (" << sprites.tiles.size() << " tiles, "
+                  << sprites.palettes.size() << " palettes) into '" << out_file << "' in " << ms << " ms." << std::endl;
+        if (cache) {
+            std::cout << "Sprite cache '" << cache->directory << "': " << cache->hits << " hits, " << cache->misses << " misses";
+            if (prune) {
+                std::cout << ", " << cache->prune() << " unused entries pruned";
+            }
+            std::cout << "." << std::endl;
+        }
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
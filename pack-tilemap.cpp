@@ -0,0 +1,121 @@
+// pack-tilemap -- bake a text level layout into a compressed tilemap, ahead of time.
+//
+// Usage:
+//   dist/pack-tilemap <level.txt> <out.tilemap>
+//
+// The layout starts with lines 'tile <char> <sprite> <rotation> <palette index>' saying which
+// sprite (turned 0-3 quarter turns, or 'aim' to turn with the player) and palette each character
+// stands for, then a line 'rows', then the map: one line per row, top row first, every row the same
+// width (see assets/level.txt). The entries (legend index | palette << 8) are compressed as described
+// in Tilemap.hpp and written, along with the legend, in the format Tilemap reads.
+
+#include "Tilemap.hpp"
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    if (argc != 3) {
+        std::cerr << "Usage:\n\t" << argv[0] << " <level.txt> <out.tilemap>" << std::endl;
+        return 1;
+    }
+    std::string const level_file = argv[1];
+    std::string const out_file = argv[2];
+    try {
+        auto before = std::chrono::high_resolution_clock::now();
+        std::ifstream level(level_file);
+        if (!level) {
+            throw std::runtime_error("Failed to open level '" + level_file + "'.");
+        }
+
+        std::vector<Tilemap::Tile> legend;
+        std::array<int32_t, 256> entry_for; // (by character)
+        entry_for.fill(-1);
+        std::vector<std::string> rows;
+        bool in_rows = false;
+        std::string line;
+        uint32_t line_number = 0;
+        while (std::getline(level, line)) {
+            line_number++;
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            auto error = [&](std::string const& what) {
+                return std::runtime_error(level_file + " line " + std::to_string(line_number) + ": " + what);
+            };
+            if (in_rows) {
+                // (every character is a tile here, '#' included)
+                if (line.empty()) {
+                    continue;
+                }
+                if (!rows.empty() && line.size() != rows[0].size()) {
+                    throw error("row is " + std::to_string(line.size()) + " tiles wide, expecting " + std::to_string(rows[0].size()) + ".");
+                }
+                for (char c : line) {
+                    if (entry_for[uint8_t(c)] < 0) {
+                        throw error(std::string("no 'tile' line for '") + c + "'.");
+                    }
+                }
+                rows.emplace_back(line);
+                continue;
+            }
+            std::istringstream tokens(line.substr(0, line.find('#')));
+            std::string keyword;
+            if (!(tokens >> keyword)) {
+                continue; // blank line
+            }
+            if (keyword == "rows") {
+                in_rows = true;
+                continue;
+            }
+            std::string c, rotation;
+            Tilemap::Tile tile;
+            uint32_t palette = 0;
+            if (keyword != "tile" || !(tokens >> c >> tile.sprite >> rotation >> palette) || c.size() != 1 || palette > 0x7
+                || !(rotation == "aim" || (rotation.size() == 1 && rotation[0] >= '0' && rotation[0] <= '3'))) {
+                throw error("expecting 'tile <char> <sprite> <rotation 0-3 or aim> <palette 0-7>' or 'rows'");
+            }
+            if (entry_for[uint8_t(c[0])] >= 0) {
+                throw error("'" + c + "' already has a 'tile' line.");
+            }
+            if (legend.size() == 256) {
+                throw error("more than 256 'tile' lines.");
+            }
+            tile.rotation = (rotation == "aim" ? Tilemap::FollowsAim : uint32_t(rotation[0] - '0'));
+            entry_for[uint8_t(c[0])] = int32_t((palette << 8) | legend.size());
+            legend.emplace_back(tile);
+        }
+        if (rows.empty()) {
+            throw std::runtime_error(level_file + " has no rows.");
+        }
+
+        // (the file lists the top row first; PPU466::background starts from the bottom)
+        const uint32_t width = uint32_t(rows[0].size()), height = uint32_t(rows.size());
+        std::vector<uint16_t> entries;
+        entries.reserve(size_t(width) * height);
+        for (auto row = rows.rbegin(); row != rows.rend(); ++row) {
+            for (char c : *row) {
+                entries.emplace_back(uint16_t(entry_for[uint8_t(c)]));
+            }
+        }
+
+        Tilemap tilemap = Tilemap::encode(width, height, entries.data());
+        tilemap.legend = std::move(legend);
+        tilemap.save(out_file);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - before).count();
+        std::cout << "Packed a " << width << "x" << height << " tilemap into '" << out_file << "' (" << tilemap.encoded.size() * 2
+                  << " bytes, from " << entries.size() * 2 << ") in " << ms << " ms." << std::endl;
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
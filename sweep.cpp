@@ -0,0 +1,256 @@
+// sweep -- play many games for every combination of some balance values, to tune the GameConfig.
+//
+// Usage:
+//   dist/sweep --grid NAME=V1,V2,... [--grid ...] [--config FILE] [--games N] [--seed S] [--bot] [--threads T] [--csv FILE] [--json FILE]
+//
+// Every --grid adds one axis (NAME is a GameConfig value, see Game.hpp); every combination of
+//  the axes is a point, played with the values from --config (or the defaults) plus that point's values.
+// Every point plays the same N seeds (S, S+1, ...) so that differences between points come from the
+//  config rather than from luck. Input is random unless --bot is given.
+// All the games of all the points are spread over one ThreadPool.
+//
+// Example:
+//   dist/sweep --grid siphon_speed=60,80,100 --grid projectiles=3,5,8 --games 2000 --csv sweep.csv
+
+#include "Bot.hpp"
+#include "Game.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct Axis {
+    std::string name;
+    std::vector<std::string> values;
+};
+
+struct GameResult {
+    int score = 0;
+    uint64_t ticks = 0;
+    uint32_t hits = 0;
+    uint32_t redirects = 0;
+};
+
+struct PointStats {
+    GameConfig config;
+    std::vector<std::string> values; // (one per axis)
+    double mean = 0.0, stddev = 0.0, ci95 = 0.0; // score
+    int min = 0, max = 0;
+    double hits = 0.0, redirects = 0.0; // per game
+    double hit_rate = 0.0; // hits per redirect (can be over 1: projectiles can hit targets without being redirected)
+    double hits_per_minute = 0.0;
+};
+
+static const float TickDt = 1.0f / 60.0f;
+
+static GameResult play(GameConfig const& config, uint32_t seed, bool use_bot)
+{
+    GameResult result;
+    Game game(seed, 1, config);
+    RandomInput random_input(seed);
+    Bot bot;
+    while (!game.over()) {
+        game.set_buttons(use_bot ? bot.next(game) : random_input.next());
+        game.update(TickDt);
+        result.ticks++;
+        for (uint32_t e = 0; e < game.event_count; ++e) {
+            result.hits += (game.events[e].type == GameEvent::Hit);
+            result.redirects += (game.events[e].type == GameEvent::Redirect);
+        }
+    }
+    result.score = game.score;
+    return result;
+}
+
+static Axis parse_axis(std::string const& arg)
+{
+    Axis axis;
+    size_t equals = arg.find('=');
+    if (equals == std::string::npos) {
+        throw std::runtime_error("Expecting --grid NAME=V1,V2,... not '" + arg + "'.");
+    }
+    axis.name = arg.substr(0, equals);
+    for (size_t start = equals + 1; start <= arg.size();) {
+        size_t comma = std::min(arg.find(',', start), arg.size());
+        axis.values.emplace_back(arg.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return axis;
+}
+
+static PointStats summarize(GameConfig const& config, std::vector<std::string> const& values, GameResult const* results, uint32_t games)
+{
+    PointStats stats;
+    stats.config = config;
+    stats.values = values;
+    stats.min = results[0].score;
+    stats.max = results[0].score;
+    uint64_t ticks = 0, hits = 0, redirects = 0;
+    for (uint32_t g = 0; g < games; ++g) {
+        GameResult const& r = results[g];
+        stats.mean += r.score;
+        stats.min = std::min(stats.min, r.score);
+        stats.max = std::max(stats.max, r.score);
+        ticks += r.ticks;
+        hits += r.hits;
+        redirects += r.redirects;
+    }
+    stats.mean /= games;
+    for (uint32_t g = 0; g < games; ++g) {
+        stats.stddev += (results[g].score - stats.mean) * (results[g].score - stats.mean);
+    }
+    stats.stddev = std::sqrt(stats.stddev / games);
+    stats.ci95 = 1.96 * stats.stddev / std::sqrt(double(games));
+    stats.hits = double(hits) / games;
+    stats.redirects = double(redirects) / games;
+    stats.hit_rate = double(hits) / std::max<uint64_t>(1, redirects);
+    stats.hits_per_minute = hits / std::max(1e-9, ticks * double(TickDt) / 60.0);
+    return stats;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<Axis> axes;
+    GameConfig base;
+    uint32_t games = 500;
+    uint32_t seed = 0;
+    uint32_t threads = 0;
+    bool use_bot = false;
+    std::string csv_file, json_file;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--grid" && i + 1 < argc) {
+                axes.emplace_back(parse_axis(argv[++i]));
+            } else if (arg == "--config" && i + 1 < argc) {
+                base = GameConfig::load(argv[++i]);
+            } else if (arg == "--games" && i + 1 < argc) {
+                games = std::max(1U, uint32_t(std::stoul(argv[++i])));
+            } else if (arg == "--seed" && i + 1 < argc) {
+                seed = uint32_t(std::stoul(argv[++i]));
+            } else if (arg == "--bot") {
+                use_bot = true;
+            } else if (arg == "--threads" && i + 1 < argc) {
+                threads = uint32_t(std::stoul(argv[++i]));
+            } else if (arg == "--csv" && i + 1 < argc) {
+                csv_file = argv[++i];
+            } else if (arg == "--json" && i + 1 < argc) {
+                json_file = argv[++i];
+            } else {
+                std::cerr << "Usage:\n\t" << argv[0] << " --grid NAME=V1,V2,... [--grid ...] [--config FILE] [--games N] [--seed S] [--bot] [--threads T] [--csv FILE] [--json FILE]" << std::endl;
+                std::cerr << "Values that can be swept:";
+                for (std::string const& name : GameConfig::names()) {
+                    std::cerr << ' ' << name;
+                }
+                std::cerr << std::endl;
+                return 1;
+            }
+        }
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    // every combination of the axes' values (the first axis varies slowest):
+    std::vector<GameConfig> configs;
+    std::vector<std::vector<std::string>> point_values;
+    size_t points = 1;
+    for (Axis const& axis : axes) {
+        points *= axis.values.size();
+    }
+    try {
+        for (size_t p = 0; p < points; ++p) {
+            GameConfig config = base;
+            std::vector<std::string> values(axes.size());
+            size_t rest = p;
+            for (size_t a = axes.size(); a-- > 0;) {
+                values[a] = axes[a].values[rest % axes[a].values.size()];
+                rest /= axes[a].values.size();
+                config.set(axes[a].name, values[a]);
+            }
+            Game check(seed, 1, config); // (throws if the pools can't hold what the config asks for)
+            configs.emplace_back(config);
+            point_values.emplace_back(values);
+        }
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    // play every game of every point:
+    std::vector<GameResult> results(points * games);
+    ThreadPool pool(threads);
+    auto before = std::chrono::high_resolution_clock::now();
+    pool.parallel_for(results.size(), [&](size_t i) {
+        results[i] = play(configs[i / games], seed + uint32_t(i % games), use_bot);
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - before).count();
+
+    std::vector<PointStats> stats;
+    for (size_t p = 0; p < points; ++p) {
+        stats.emplace_back(summarize(configs[p], point_values[p], &results[p * games], games));
+    }
+
+    std::cout << "Played " << points << " points x " << games << " games (" << (use_bot ? "bot" : "random") << " input) on "
+              << threads << " threads in " << seconds << "s (" << results.size() / std::max(1e-9, seconds) << " games/sec)." << std::endl;
+    for (Axis const& axis : axes) {
+        std::printf("%8s ", axis.name.c_str());
+    }
+    std::printf("  score (95%% ci)    stddev  min  max  hits/game  hits/redirect  hits/min\n");
+    for (PointStats const& s : stats) {
+        for (size_t a = 0; a < axes.size(); ++a) {
+            std::printf("%*s ", int(std::max<size_t>(8, axes[a].name.size())), s.values[a].c_str());
+        }
+        std::printf("  %6.2f (+-%5.2f)  %6.2f  %3d  %3d  %9.2f  %13.3f  %8.2f\n",
+            s.mean, s.ci95, s.stddev, s.min, s.max, s.hits, s.hit_rate, s.hits_per_minute);
+    }
+
+    // (every config value is written out, not just the swept ones, so rows can be fed straight back in)
+    std::vector<std::string> names = GameConfig::names();
+    if (!csv_file.empty()) {
+        std::ofstream csv(csv_file);
+        for (std::string const& name : names) {
+            csv << name << ',';
+        }
+        csv << "games,score_mean,score_stddev,score_ci95,score_min,score_max,hits_per_game,redirects_per_game,hit_rate,hits_per_minute\n";
+        for (PointStats const& s : stats) {
+            for (std::string const& name : names) {
+                csv << s.config.get(name) << ',';
+            }
+            csv << games << ',' << s.mean << ',' << s.stddev << ',' << s.ci95 << ',' << s.min << ',' << s.max << ','
+                << s.hits << ',' << s.redirects << ',' << s.hit_rate << ',' << s.hits_per_minute << '\n';
+        }
+        std::cout << "Wrote " << stats.size() << " points to '" << csv_file << "'." << std::endl;
+    }
+    if (!json_file.empty()) {
+        std::ofstream json(json_file);
+        json << "[\n";
+        for (size_t p = 0; p < stats.size(); ++p) {
+            PointStats const& s = stats[p];
+            json << "  { \"config\": {";
+            for (size_t n = 0; n < names.size(); ++n) {
+                json << (n ? ", " : " ") << '"' << names[n] << "\": " << s.config.get(names[n]);
+            }
+            json << " },\n    \"games\": " << games
+                 << ", \"score\": { \"mean\": " << s.mean << ", \"stddev\": " << s.stddev << ", \"ci95\": " << s.ci95
+                 << ", \"min\": " << s.min << ", \"max\": " << s.max << " }"
+                 << ", \"hits_per_game\": " << s.hits << ", \"redirects_per_game\": " << s.redirects
+                 << ", \"hit_rate\": " << s.hit_rate << ", \"hits_per_minute\": " << s.hits_per_minute
+                 << " }" << (p + 1 < stats.size() ? "," : "") << "\n";
+        }
+        json << "]\n";
+        std::cout << "Wrote " << stats.size() << " points to '" << json_file << "'." << std::endl;
+    }
+
+    return 0;
+}